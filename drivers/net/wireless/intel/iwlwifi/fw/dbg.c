@@ -5,6 +5,7 @@
  * Copyright (C) 2015-2017 Intel Deutschland GmbH
  */
 #include <linux/devcoredump.h>
+#include <linux/vmalloc.h>
 #include "iwl-drv.h"
 #include "runtime.h"
 #include "dbg.h"
@@ -596,6 +597,39 @@ static struct scatterlist *alloc_sgtable(int size)
 	return table;
 }
 
+static void free_sgtable(struct scatterlist *table)
+{
+	struct scatterlist *iter;
+	int i;
+
+	for_each_sg(table, iter, sg_nents(table), i)
+		__free_page(sg_page(iter));
+	kfree(table);
+}
+
+/*
+ * trim_sgtable - release the pages of the table beyond the given size
+ * @size: the size (in bytes) the table is trimmed to, must not be 0
+ */
+static void trim_sgtable(struct scatterlist *table, u32 size)
+{
+	struct scatterlist *iter, *last = table;
+	int i;
+
+	for_each_sg(table, iter, sg_nents(table), i) {
+		if (size) {
+			iter->length = min_t(u32, size, PAGE_SIZE);
+			size -= iter->length;
+			last = iter;
+			continue;
+		}
+
+		__free_page(sg_page(iter));
+		sg_assign_page(iter, NULL);
+	}
+	sg_mark_end(last);
+}
+
 static void iwl_fw_get_prph_len(struct iwl_fw_runtime *fwrt,
 				const struct iwl_prph_range *iwl_prph_dump_addr,
 				u32 range_len, void *ptr)
@@ -2203,11 +2237,56 @@ struct iwl_dump_ini_mem_ops {
 			  void *range, u32 range_len, int idx);
 };
 
+/**
+ * struct iwl_dump_ini_buf - ini dump file being collected
+ *
+ * The dump file is collected in two passes over the same regions: the
+ * first only computes its size, the second writes it straight into the
+ * pages that are handed to devcoredump.
+ *
+ * @sgl: page backed scatterlist holding the dump file
+ * @data: virtually contiguous mapping of the pages of @sgl, or %NULL
+ *	while computing the size of the dump file
+ * @size: size of @data
+ * @len: length of the dump file so far
+ */
+struct iwl_dump_ini_buf {
+	struct scatterlist *sgl;
+	u8 *data;
+	u32 size;
+	u32 len;
+};
+
+/*
+ * Add @size bytes to the dump file, returns a pointer to them or %NULL
+ * if only computing the size of the dump or if it doesn't fit.
+ */
+static void *iwl_dump_ini_buf_add(struct iwl_fw_runtime *fwrt,
+				  struct iwl_dump_ini_buf *buf, u32 size)
+{
+	void *data;
+
+	if (!buf->data) {
+		buf->len += size;
+		return NULL;
+	}
+
+	if (size > buf->size - buf->len) {
+		IWL_ERR(fwrt, "WRT: no room for %u bytes in the dump\n", size);
+		return NULL;
+	}
+
+	data = buf->data + buf->len;
+	buf->len += size;
+
+	return data;
+}
+
 /**
  * iwl_dump_ini_mem - dump memory region
  *
  * @fwrt: fw runtime struct
- * @list: list to add the dump tlv to
+ * @buf: dump file to add the dump tlv to
  * @reg_data: memory region
  * @ops: memory dump operations
  *
@@ -2215,12 +2294,12 @@ struct iwl_dump_ini_mem_ops {
  *
  * Returns: the size of the current dump tlv or 0 if failed
  */
-static u32 iwl_dump_ini_mem(struct iwl_fw_runtime *fwrt, struct list_head *list,
+static u32 iwl_dump_ini_mem(struct iwl_fw_runtime *fwrt,
+			    struct iwl_dump_ini_buf *buf,
 			    struct iwl_dump_ini_region_data *reg_data,
 			    const struct iwl_dump_ini_mem_ops *ops)
 {
 	struct iwl_fw_ini_region_tlv *reg = (void *)reg_data->reg_tlv->data;
-	struct iwl_fw_ini_dump_entry *entry;
 	struct iwl_fw_ini_error_dump_data *tlv;
 	struct iwl_fw_ini_error_dump_header *header;
 	u32 type = reg->type;
@@ -2272,13 +2351,10 @@ static u32 iwl_dump_ini_mem(struct iwl_fw_runtime *fwrt, struct list_head *list,
 		return 0;
 	}
 
-	entry = vzalloc(sizeof(*entry) + sizeof(*tlv) + size);
-	if (!entry)
-		return 0;
-
-	entry->size = sizeof(*tlv) + size;
+	tlv = iwl_dump_ini_buf_add(fwrt, buf, sizeof(*tlv) + size);
+	if (!tlv)
+		return buf->data ? 0 : sizeof(*tlv) + size;
 
-	tlv = (void *)entry->data;
 	tlv->type = reg->type;
 	tlv->sub_type = reg->sub_type;
 	tlv->sub_type_ver = reg->sub_type_ver;
@@ -2336,21 +2412,20 @@ static u32 iwl_dump_ini_mem(struct iwl_fw_runtime *fwrt, struct list_head *list,
 		range = range + range_size;
 	}
 
-	list_add_tail(&entry->list, list);
-
-	return entry->size;
+	return sizeof(*tlv) + size;
 
 out_err:
-	vfree(entry);
+	/* drop it from the dump, the next tlv can reuse the space */
+	memset(tlv, 0, sizeof(*tlv) + size);
+	buf->len -= sizeof(*tlv) + size;
 
 	return 0;
 }
 
 static u32 iwl_dump_ini_info(struct iwl_fw_runtime *fwrt,
 			     struct iwl_fw_ini_trigger_tlv *trigger,
-			     struct list_head *list)
+			     struct iwl_dump_ini_buf *buf)
 {
-	struct iwl_fw_ini_dump_entry *entry;
 	struct iwl_fw_error_dump_data *tlv;
 	struct iwl_fw_ini_dump_info *dump;
 	struct iwl_dbg_tlv_node *node;
@@ -2364,13 +2439,10 @@ static u32 iwl_dump_ini_info(struct iwl_fw_runtime *fwrt,
 		num_of_cfg_names++;
 	}
 
-	entry = vzalloc(sizeof(*entry) + size);
-	if (!entry)
-		return 0;
-
-	entry->size = size;
+	tlv = iwl_dump_ini_buf_add(fwrt, buf, size);
+	if (!tlv)
+		return buf->data ? 0 : size;
 
-	tlv = (void *)entry->data;
 	tlv->type = cpu_to_le32(IWL_INI_DUMP_INFO_TYPE);
 	tlv->len = cpu_to_le32(size - sizeof(*tlv));
 
@@ -2444,18 +2516,12 @@ static u32 iwl_dump_ini_info(struct iwl_fw_runtime *fwrt,
 		cfg_name++;
 	}
 
-	/* add dump info TLV to the beginning of the list since it needs to be
-	 * the first TLV in the dump
-	 */
-	list_add(&entry->list, list);
-
-	return entry->size;
+	return size;
 }
 
 static u32 iwl_dump_ini_file_name_info(struct iwl_fw_runtime *fwrt,
-				       struct list_head *list)
+				       struct iwl_dump_ini_buf *buf)
 {
-	struct iwl_fw_ini_dump_entry *entry;
 	struct iwl_dump_file_name_info *tlv;
 	u32 len = strnlen(fwrt->trans->dbg.dump_file_name_ext,
 			  IWL_FW_INI_MAX_NAME);
@@ -2463,23 +2529,17 @@ static u32 iwl_dump_ini_file_name_info(struct iwl_fw_runtime *fwrt,
 	if (!fwrt->trans->dbg.dump_file_name_ext_valid)
 		return 0;
 
-	entry = vzalloc(sizeof(*entry) + sizeof(*tlv) + len);
-	if (!entry)
-		return 0;
-
-	entry->size = sizeof(*tlv) + len;
+	tlv = iwl_dump_ini_buf_add(fwrt, buf, sizeof(*tlv) + len);
+	if (!tlv)
+		return buf->data ? 0 : sizeof(*tlv) + len;
 
-	tlv = (void *)entry->data;
 	tlv->type = cpu_to_le32(IWL_INI_DUMP_NAME_TYPE);
 	tlv->len = cpu_to_le32(len);
 	memcpy(tlv->data, fwrt->trans->dbg.dump_file_name_ext, len);
 
-	/* add the dump file name extension tlv to the list */
-	list_add_tail(&entry->list, list);
-
 	fwrt->trans->dbg.dump_file_name_ext_valid = false;
 
-	return entry->size;
+	return sizeof(*tlv) + len;
 }
 
 static const struct iwl_dump_ini_mem_ops iwl_dump_ini_region_ops[] = {
@@ -2603,7 +2663,7 @@ static const struct iwl_dump_ini_mem_ops iwl_dump_ini_region_ops[] = {
 
 static u32 iwl_dump_ini_trigger(struct iwl_fw_runtime *fwrt,
 				struct iwl_fwrt_dump_data *dump_data,
-				struct list_head *list)
+				struct iwl_dump_ini_buf *buf)
 {
 	struct iwl_fw_ini_trigger_tlv *trigger = dump_data->trig;
 	enum iwl_fw_ini_time_point tp_id = le32_to_cpu(trigger->time_point);
@@ -2614,7 +2674,7 @@ static u32 iwl_dump_ini_trigger(struct iwl_fw_runtime *fwrt,
 		.dump_data = dump_data,
 	};
 	int i;
-	u32 size = 0;
+	u32 size = 0, info_size;
 	u64 regions_mask = le64_to_cpu(trigger->regions_mask) &
 			   ~(fwrt->trans->dbg.unsupported_region_msk);
 
@@ -2622,6 +2682,11 @@ static u32 iwl_dump_ini_trigger(struct iwl_fw_runtime *fwrt,
 	BUILD_BUG_ON((sizeof(trigger->regions_mask) * BITS_PER_BYTE) <
 		     ARRAY_SIZE(fwrt->trans->dbg.active_regions));
 
+	/* the dump info TLV needs to be the first TLV in the dump */
+	info_size = iwl_dump_ini_info(fwrt, trigger, buf);
+	if (!info_size)
+		return 0;
+
 	for (i = 0; i < ARRAY_SIZE(fwrt->trans->dbg.active_regions); i++) {
 		u32 reg_type;
 		struct iwl_fw_ini_region_tlv *reg;
@@ -2669,20 +2734,18 @@ static u32 iwl_dump_ini_trigger(struct iwl_fw_runtime *fwrt,
 		}
 
 
-		size += iwl_dump_ini_mem(fwrt, list, &reg_data,
+		size += iwl_dump_ini_mem(fwrt, buf, &reg_data,
 					 &iwl_dump_ini_region_ops[reg_type]);
 	}
 	/* collect DRAM_IMR region in the last */
 	if (imr_reg_data.reg_tlv)
-		size += iwl_dump_ini_mem(fwrt, list, &reg_data,
+		size += iwl_dump_ini_mem(fwrt, buf, &reg_data,
 					 &iwl_dump_ini_region_ops[IWL_FW_INI_REGION_DRAM_IMR]);
 
-	if (size) {
-		size += iwl_dump_ini_file_name_info(fwrt, list);
-		size += iwl_dump_ini_info(fwrt, trigger, list);
-	}
+	if (!size)
+		return 0;
 
-	return size;
+	return info_size + size + iwl_dump_ini_file_name_info(fwrt, buf);
 }
 
 static bool iwl_fw_ini_trigger_on(struct iwl_fw_runtime *fwrt,
@@ -2702,36 +2765,58 @@ static bool iwl_fw_ini_trigger_on(struct iwl_fw_runtime *fwrt,
 
 static u32 iwl_dump_ini_file_gen(struct iwl_fw_runtime *fwrt,
 				 struct iwl_fwrt_dump_data *dump_data,
-				 struct list_head *list)
+				 struct iwl_dump_ini_buf *buf)
 {
-	struct iwl_fw_ini_trigger_tlv *trigger = dump_data->trig;
-	struct iwl_fw_ini_dump_entry *entry;
 	struct iwl_fw_ini_dump_file_hdr *hdr;
-	u32 size;
 
-	if (!trigger || !iwl_fw_ini_trigger_on(fwrt, trigger) ||
-	    !le64_to_cpu(trigger->regions_mask))
+	hdr = iwl_dump_ini_buf_add(fwrt, buf, sizeof(*hdr));
+	if (!hdr && buf->data)
 		return 0;
 
-	entry = vzalloc(sizeof(*entry) + sizeof(*hdr));
-	if (!entry)
+	if (!iwl_dump_ini_trigger(fwrt, dump_data, buf))
 		return 0;
 
-	entry->size = sizeof(*hdr);
-
-	size = iwl_dump_ini_trigger(fwrt, dump_data, list);
-	if (!size) {
-		vfree(entry);
-		return 0;
+	if (hdr) {
+		hdr->barker = cpu_to_le32(IWL_FW_INI_ERROR_DUMP_BARKER);
+		hdr->file_len = cpu_to_le32(buf->len);
 	}
 
-	hdr = (void *)entry->data;
-	hdr->barker = cpu_to_le32(IWL_FW_INI_ERROR_DUMP_BARKER);
-	hdr->file_len = cpu_to_le32(size + entry->size);
+	return buf->len;
+}
+
+static int iwl_dump_ini_buf_alloc(struct iwl_dump_ini_buf *buf, u32 size)
+{
+	struct scatterlist *iter;
+	struct page **pages;
+	int nents, i;
+
+	buf->sgl = alloc_sgtable(size);
+	if (!buf->sgl)
+		return -ENOMEM;
+
+	nents = sg_nents(buf->sgl);
+	pages = kvmalloc_array(nents, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		goto err;
+
+	for_each_sg(buf->sgl, iter, nents, i)
+		pages[i] = sg_page(iter);
 
-	list_add(&entry->list, list);
+	buf->data = vmap(pages, nents, VM_MAP, PAGE_KERNEL);
+	kvfree(pages);
+	if (!buf->data)
+		goto err;
+
+	memset(buf->data, 0, size);
+	buf->size = size;
+	buf->len = 0;
+
+	return 0;
 
-	return le32_to_cpu(hdr->file_len);
+err:
+	free_sgtable(buf->sgl);
+	buf->sgl = NULL;
+	return -ENOMEM;
 }
 
 static inline void iwl_fw_free_dump_desc(struct iwl_fw_runtime *fwrt,
@@ -2792,17 +2877,6 @@ static void iwl_fw_error_dump(struct iwl_fw_runtime *fwrt,
 	vfree(fw_error_dump.trans_ptr);
 }
 
-static void iwl_dump_ini_list_free(struct list_head *list)
-{
-	while (!list_empty(list)) {
-		struct iwl_fw_ini_dump_entry *entry =
-			list_entry(list->next, typeof(*entry), list);
-
-		list_del(&entry->list);
-		vfree(entry);
-	}
-}
-
 static void iwl_fw_error_dump_data_free(struct iwl_fwrt_dump_data *dump_data)
 {
 	dump_data->trig = NULL;
@@ -2813,28 +2887,41 @@ static void iwl_fw_error_dump_data_free(struct iwl_fwrt_dump_data *dump_data)
 static void iwl_fw_error_ini_dump(struct iwl_fw_runtime *fwrt,
 				  struct iwl_fwrt_dump_data *dump_data)
 {
-	LIST_HEAD(dump_list);
-	struct scatterlist *sg_dump_data;
-	u32 file_len = iwl_dump_ini_file_gen(fwrt, dump_data, &dump_list);
+	struct iwl_fw_ini_trigger_tlv *trigger = dump_data->trig;
+	struct iwl_dump_ini_buf buf = {};
+	ktime_t start = ktime_get();
+	u32 size, file_len;
 
-	if (!file_len)
+	if (!trigger || !iwl_fw_ini_trigger_on(fwrt, trigger) ||
+	    !le64_to_cpu(trigger->regions_mask))
 		return;
 
-	sg_dump_data = alloc_sgtable(file_len);
-	if (sg_dump_data) {
-		struct iwl_fw_ini_dump_entry *entry;
-		int sg_entries = sg_nents(sg_dump_data);
-		u32 offs = 0;
-
-		list_for_each_entry(entry, &dump_list, list) {
-			sg_pcopy_from_buffer(sg_dump_data, sg_entries,
-					     entry->data, entry->size, offs);
-			offs += entry->size;
-		}
-		dev_coredumpsg(fwrt->trans->dev, sg_dump_data, file_len,
-			       GFP_KERNEL);
+	size = iwl_dump_ini_file_gen(fwrt, dump_data, &buf);
+	if (!size)
+		return;
+
+	if (iwl_dump_ini_buf_alloc(&buf, size)) {
+		IWL_ERR(fwrt, "WRT: failed to allocate %u bytes for the dump\n",
+			size);
+		return;
 	}
-	iwl_dump_ini_list_free(&dump_list);
+
+	file_len = iwl_dump_ini_file_gen(fwrt, dump_data, &buf);
+	vunmap(buf.data);
+	if (!file_len) {
+		free_sgtable(buf.sgl);
+		return;
+	}
+
+	trim_sgtable(buf.sgl, file_len);
+
+	fwrt->dump.last_ini_dump.len = file_len;
+	fwrt->dump.last_ini_dump.peak_mem =
+		DIV_ROUND_UP(size, PAGE_SIZE) *
+		(PAGE_SIZE + sizeof(struct scatterlist));
+	fwrt->dump.last_ini_dump.usec = ktime_us_delta(ktime_get(), start);
+
+	dev_coredumpsg(fwrt->trans->dev, buf.sgl, file_len, GFP_KERNEL);
 }
 
 const struct iwl_fw_dump_desc iwl_dump_desc_assert = {
@@ -283,6 +283,18 @@ static ssize_t iwl_dbgfs_fw_dbg_domain_read(struct iwl_fw_runtime *fwrt,
 
 FWRT_DEBUGFS_READ_FILE_OPS(fw_dbg_domain, 20);
 
+static ssize_t iwl_dbgfs_last_ini_dump_read(struct iwl_fw_runtime *fwrt,
+					    size_t size, char *buf)
+{
+	return scnprintf(buf, size,
+			 "len: %u\npeak memory: %u\ntime: %u usec\n",
+			 fwrt->dump.last_ini_dump.len,
+			 fwrt->dump.last_ini_dump.peak_mem,
+			 fwrt->dump.last_ini_dump.usec);
+}
+
+FWRT_DEBUGFS_READ_FILE_OPS(last_ini_dump, 80);
+
 struct iwl_dbgfs_fw_info_priv {
 	struct iwl_fw_runtime *fwrt;
 };
@@ -405,4 +417,5 @@ void iwl_fwrt_dbgfs_register(struct iwl_fw_runtime *fwrt,
 	FWRT_DEBUGFS_ADD_FILE(send_hcmd, dbgfs_dir, 0200);
 	FWRT_DEBUGFS_ADD_FILE(enabled_severities, dbgfs_dir, 0200);
 	FWRT_DEBUGFS_ADD_FILE(fw_dbg_domain, dbgfs_dir, 0400);
+	FWRT_DEBUGFS_ADD_FILE(last_ini_dump, dbgfs_dir, 0400);
 }
@@ -152,6 +152,13 @@ struct iwl_fw_runtime {
 			u32 umac_major;
 			u32 umac_minor;
 		} fw_ver;
+
+		/* size, peak memory use and duration of the last ini dump */
+		struct {
+			u32 len;
+			u32 peak_mem;
+			u32 usec;
+		} last_ini_dump;
 	} dump;
 	struct {
 #ifdef CPTCFG_IWLWIFI_DEBUGFS
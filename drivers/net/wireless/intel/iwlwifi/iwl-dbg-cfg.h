@@ -102,6 +102,7 @@ struct iwl_dbg_cfg {
 	IWL_DBG_CFG(u32, MVM_TCM_LOAD_MEDIUM_THRESH)
 	IWL_DBG_CFG(u32, MVM_TCM_LOAD_HIGH_THRESH)
 	IWL_DBG_CFG(u32, MVM_TCM_LOWLAT_ENABLE_THRESH)
+	IWL_DBG_CFG_RANGE(u16, MVM_TCM_PERIOD_MSEC, 10, 10000)
 	IWL_DBG_CFG(u32, MVM_UAPSD_NONAGG_PERIOD)
 	IWL_DBG_CFG_RANGE(u8, MVM_UAPSD_NOAGG_LIST_LEN,
 			  1, IWL_MVM_UAPSD_NOAGG_BSSIDS_NUM)
@@ -130,6 +131,7 @@ struct iwl_dbg_cfg {
 	IWL_DBG_CFG(u8, MVM_RS_STAY_IN_COLUMN_TIMEOUT)
 	IWL_DBG_CFG(u8, MVM_RS_IDLE_TIMEOUT)
 	IWL_DBG_CFG(u8, MVM_RS_MISSED_RATE_MAX)
+	IWL_DBG_CFG(u8, MVM_RS_LQ_COALESCE_MSEC)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_FAILURE_LIMIT)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_SUCCESS_LIMIT)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_TABLE_COUNT)
@@ -129,6 +129,27 @@ TRACE_EVENT(iwlwifi_dev_ucode_event,
 		  __get_str(dev), __entry->time, __entry->data, __entry->ev)
 );
 
+TRACE_EVENT(iwlwifi_dev_start_phase,
+	TP_PROTO(const struct device *dev, u32 phase, u32 usec, bool restart),
+	TP_ARGS(dev, phase, usec, restart),
+	TP_STRUCT__entry(
+		DEV_ENTRY
+
+		__field(u32, phase)
+		__field(u32, usec)
+		__field(bool, restart)
+	),
+	TP_fast_assign(
+		DEV_ASSIGN;
+		__entry->phase = phase;
+		__entry->usec = usec;
+		__entry->restart = restart;
+	),
+	TP_printk("[%s] %sstart phase %u took %u usec",
+		  __get_str(dev), __entry->restart ? "re" : "",
+		  __entry->phase, __entry->usec)
+);
+
 #ifdef CPTCFG_IWLWIFI_DEVICE_TESTMODE
 	TRACE_EVENT(iwlwifi_dev_dnt_data,
 	TP_PROTO(const struct device *dev,
@@ -53,6 +53,7 @@ static struct dentry *iwl_dbgfs_root;
  * @fw_index: firmware revision to try loading
  * @firmware_name: composite filename of ucode file to load
  * @request_firmware_complete: the firmware has been obtained from user space
+ * @fw_request_start: time the current firmware file was requested
  * @dbgfs_drv: debugfs root directory entry
  * @dbgfs_trans: debugfs transport directory entry
  * @dbgfs_op_mode: debugfs op_mode directory entry
@@ -75,6 +76,7 @@ struct iwl_drv {
 	char firmware_name[64];         /* name of firmware file to load */
 
 	struct completion request_firmware_complete;
+	ktime_t fw_request_start;
 
 #ifdef CPTCFG_IWLWIFI_DEBUGFS
 	struct dentry *dbgfs_drv;
@@ -509,6 +511,7 @@ static int iwl_request_firmware(struct iwl_drv *drv, bool first)
 	IWL_DEBUG_FW_INFO(drv, "attempting to load firmware '%s'\n",
 			  drv->firmware_name);
 
+	drv->fw_request_start = ktime_get();
 	return request_firmware_nowait(THIS_MODULE, 1, drv->firmware_name,
 				       drv->trans->dev,
 				       GFP_KERNEL, drv, iwl_req_fw_callback);
@@ -1768,11 +1771,15 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	bool load_module = false;
 	bool usniffer_images = false;
 	bool failure = true;
+	ktime_t start;
 #ifdef CPTCFG_IWLWIFI_SUPPORT_DEBUG_OVERRIDES
 	const struct firmware *fw_dbg_config;
 	int load_fw_dbg_err = -ENOENT;
 #endif
 
+	iwl_trans_start_phase_done(drv->trans, IWL_START_PHASE_FW_REQUEST,
+				   drv->fw_request_start);
+
 	fw->ucode_capa.max_probe_length = IWL_DEFAULT_MAX_PROBE_LENGTH;
 	fw->ucode_capa.standard_phy_calibration_size =
 			IWL_DEFAULT_STANDARD_PHY_CALIBRATE_TBL_SIZE;
@@ -1801,11 +1808,13 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	/* Data from ucode file:  header followed by uCode images */
 	ucode = (const struct iwl_ucode_header *)ucode_raw->data;
 
+	start = ktime_get();
 	if (ucode->ver)
 		err = iwl_parse_v1_v2_firmware(drv, ucode_raw, pieces);
 	else
 		err = iwl_parse_tlv_firmware(drv, ucode_raw, pieces,
 					     &fw->ucode_capa, &usniffer_images);
+	iwl_trans_start_phase_done(drv->trans, IWL_START_PHASE_FW_PARSE, start);
 
 	if (err)
 		goto try_again;
@@ -2039,7 +2048,10 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	list_add_tail(&drv->list, &op->drv);
 
 	if (op->ops) {
+		start = ktime_get();
 		drv->op_mode = _iwl_op_mode_start(drv, op);
+		iwl_trans_start_phase_done(drv->trans,
+					   IWL_START_PHASE_OP_MODE_START, start);
 
 		if (!drv->op_mode) {
 			mutex_unlock(&iwlwifi_opmode_table_mtx);
@@ -2088,6 +2100,58 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	}
 }
 
+#ifdef CPTCFG_IWLWIFI_DEBUGFS
+static ssize_t iwl_dbgfs_start_timing_read(struct file *file,
+					   char __user *user_buf,
+					   size_t count, loff_t *ppos)
+{
+	struct iwl_drv *drv = file->private_data;
+	struct iwl_trans *trans = drv->trans;
+	int i, j, pos = 0;
+	size_t bufsz;
+	char *buf;
+	ssize_t ret;
+
+	bufsz = IWL_START_TIMING_HISTORY * (IWL_START_PHASE_NUM + 2) * 48;
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	/* oldest first */
+	for (i = 1; i <= IWL_START_TIMING_HISTORY; i++) {
+		int idx = (trans->start_timing_idx + i) %
+			  IWL_START_TIMING_HISTORY;
+		const struct iwl_start_timing *timing =
+			&trans->start_timing[idx];
+
+		if (!timing->begin)
+			continue;
+
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "%s at %lld ms: total %lld usec\n",
+				 timing->restart ? "restart" : "start",
+				 ktime_to_ms(timing->begin),
+				 ktime_us_delta(timing->end, timing->begin));
+
+		for (j = 0; j < IWL_START_PHASE_NUM; j++)
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\t%-16s%u usec\n",
+					 iwl_trans_start_phase_name(j),
+					 timing->usec[j]);
+	}
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations iwl_dbgfs_start_timing_ops = {
+	.read = iwl_dbgfs_start_timing_read,
+	.open = simple_open,
+	.llseek = default_llseek,
+};
+#endif
+
 struct iwl_drv *iwl_drv_start(struct iwl_trans *trans)
 {
 	struct iwl_drv *drv;
@@ -2117,6 +2181,9 @@ struct iwl_drv *iwl_drv_start(struct iwl_trans *trans)
 
 	/* Create transport layer debugfs dir */
 	drv->trans->dbgfs_dir = debugfs_create_dir("trans", drv->dbgfs_drv);
+
+	debugfs_create_file("start_timing", 0400, drv->dbgfs_drv, drv,
+			    &iwl_dbgfs_start_timing_ops);
 #endif
 
 #ifdef CPTCFG_IWLWIFI_DEVICE_TESTMODE
@@ -2141,6 +2208,8 @@ struct iwl_drv *iwl_drv_start(struct iwl_trans *trans)
 		}
 	}
 
+	iwl_trans_start_timing_begin(trans, false);
+
 	ret = iwl_request_firmware(drv, true);
 	if (ret) {
 		IWL_ERR(trans, "Couldn't request the fw\n");
@@ -2419,3 +2488,12 @@ MODULE_PARM_DESC(remove_when_gone,
 module_param_named(disable_11be, iwlwifi_mod_params.disable_11be, bool, 0444);
 MODULE_PARM_DESC(disable_11be, "Disable EHT capabilities (default: false)");
 
+module_param_named(rx_page_recycle, iwlwifi_mod_params.rx_page_recycle,
+		   bool, 0444);
+MODULE_PARM_DESC(rx_page_recycle,
+		 "Recycle RX pages without remapping them, uses one page per RB (default: false)");
+
+module_param_named(rx_affinity, iwlwifi_mod_params.rx_affinity, charp, 0444);
+MODULE_PARM_DESC(rx_affinity,
+		 "RX queue IRQ affinity: spread, numa, housekeeping or a CPU list (default: spread)");
+
@@ -65,6 +65,10 @@ enum iwl_uapsd_disable {
  * @remove_when_gone: remove an inaccessible device from the PCIe bus.
  * @enable_ini: enable new FW debug infratructure (INI TLVs)
  * @disable_11be: disable EHT capabilities, default = false.
+ * @rx_page_recycle: keep RX pages handed to the stack DMA-mapped and reuse
+ *	them once released, default = false.
+ * @rx_affinity: RX queue IRQ affinity policy, "spread" (default), "numa",
+ *	"housekeeping" or a CPU list
  */
 struct iwl_mod_params {
 	int swcrypto;
@@ -92,6 +96,8 @@ struct iwl_mod_params {
 	bool remove_when_gone;
 	u32 enable_ini;
 	bool disable_11be;
+	bool rx_page_recycle;
+	char *rx_affinity;
 
 };
 
@@ -90,6 +90,9 @@ struct iwl_test_ops {
  *	received on the RSS queue(s). The queue parameter indicates which of the
  *	RSS queues received this frame; it will always be non-zero.
  *	This method must not sleep.
+ * @rx_done: called after the transport handled a batch of RX buffers on
+ *	the given queue, i.e. at the end of each NAPI poll. Optional, must
+ *	not sleep.
  * @queue_full: notifies that a HW queue is full.
  *	Must be atomic and called with BH disabled.
  * @queue_not_full: notifies that a HW queue is not full any more.
@@ -122,6 +125,8 @@ struct iwl_op_mode_ops {
 		   struct iwl_rx_cmd_buffer *rxb);
 	void (*rx_rss)(struct iwl_op_mode *op_mode, struct napi_struct *napi,
 		       struct iwl_rx_cmd_buffer *rxb, unsigned int queue);
+	void (*rx_done)(struct iwl_op_mode *op_mode, struct napi_struct *napi,
+			unsigned int queue);
 	void (*queue_full)(struct iwl_op_mode *op_mode, int queue);
 	void (*queue_not_full)(struct iwl_op_mode *op_mode, int queue);
 	bool (*hw_rf_kill)(struct iwl_op_mode *op_mode, bool state);
@@ -177,6 +182,14 @@ static inline void iwl_op_mode_rx_rss(struct iwl_op_mode *op_mode,
 	op_mode->ops->rx_rss(op_mode, napi, rxb, queue);
 }
 
+static inline void iwl_op_mode_rx_done(struct iwl_op_mode *op_mode,
+				       struct napi_struct *napi,
+				       unsigned int queue)
+{
+	if (op_mode->ops->rx_done)
+		op_mode->ops->rx_done(op_mode, napi, queue);
+}
+
 static inline void iwl_op_mode_queue_full(struct iwl_op_mode *op_mode,
 					  int queue)
 {
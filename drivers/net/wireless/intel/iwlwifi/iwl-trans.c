@@ -14,6 +14,7 @@
 #include "queue/tx.h"
 #include <linux/dmapool.h>
 #include "fw/api/commands.h"
+#include "iwl-devtrace.h"
 
 struct iwl_trans *iwl_trans_alloc(unsigned int priv_size,
 				  struct device *dev,
@@ -126,17 +127,8 @@ int iwl_trans_init(struct iwl_trans *trans)
 
 void iwl_trans_free(struct iwl_trans *trans)
 {
-	int i;
-
 	if (trans->txqs.tso_hdr_page) {
-		for_each_possible_cpu(i) {
-			struct iwl_tso_hdr_page *p =
-				per_cpu_ptr(trans->txqs.tso_hdr_page, i);
-
-			if (p && p->page)
-				__free_page(p->page);
-		}
-
+		iwl_txq_free_tso_hdr_pages(trans);
 		free_percpu(trans->txqs.tso_hdr_page);
 	}
 
@@ -247,3 +239,67 @@ int iwl_cmd_groups_verify_sorted(const struct iwl_trans_config *trans)
 	return 0;
 }
 IWL_EXPORT_SYMBOL(iwl_cmd_groups_verify_sorted);
+
+static const char * const iwl_start_phase_names[] = {
+	[IWL_START_PHASE_FW_REQUEST] = "fw_request",
+	[IWL_START_PHASE_FW_PARSE] = "fw_parse",
+	[IWL_START_PHASE_OP_MODE_START] = "op_mode_start",
+	[IWL_START_PHASE_PNVM] = "pnvm",
+	[IWL_START_PHASE_PAGING] = "paging",
+	[IWL_START_PHASE_NVM] = "nvm",
+	[IWL_START_PHASE_FW_UP] = "fw_up",
+};
+
+const char *iwl_trans_start_phase_name(enum iwl_start_phase phase)
+{
+	BUILD_BUG_ON(ARRAY_SIZE(iwl_start_phase_names) != IWL_START_PHASE_NUM);
+
+	if (WARN_ON(phase >= IWL_START_PHASE_NUM))
+		return "unknown";
+
+	return iwl_start_phase_names[phase];
+}
+IWL_EXPORT_SYMBOL(iwl_trans_start_phase_name);
+
+/*
+ * Start a new entry in the start timing ring. The first entry is opened
+ * by the driver when it requests the firmware, later ones whenever the
+ * op mode restarts the device after a firmware error.
+ */
+void iwl_trans_start_timing_begin(struct iwl_trans *trans, bool restart)
+{
+	struct iwl_start_timing *timing;
+
+	trans->start_timing_idx = (trans->start_timing_idx + 1) %
+				  IWL_START_TIMING_HISTORY;
+	timing = &trans->start_timing[trans->start_timing_idx];
+
+	memset(timing, 0, sizeof(*timing));
+	timing->begin = ktime_get();
+	timing->end = timing->begin;
+	timing->restart = restart;
+}
+IWL_EXPORT_SYMBOL(iwl_trans_start_timing_begin);
+
+void iwl_trans_start_phase_done(struct iwl_trans *trans,
+				enum iwl_start_phase phase, ktime_t begin)
+{
+	struct iwl_start_timing *timing =
+		&trans->start_timing[trans->start_timing_idx];
+	ktime_t now = ktime_get();
+	u32 usec = ktime_us_delta(now, begin);
+
+	if (WARN_ON(phase >= IWL_START_PHASE_NUM))
+		return;
+
+	trace_iwlwifi_dev_start_phase(trans->dev, phase, usec,
+				      timing->restart);
+
+	/* a phase outside of any start, e.g. an NVM re-read from debugfs */
+	if (!timing->begin)
+		return;
+
+	timing->usec[phase] += usec;
+	timing->end = now;
+}
+IWL_EXPORT_SYMBOL(iwl_trans_start_phase_done);
@@ -225,6 +225,8 @@ enum iwl_error_event_table_status {
  * @dataflags: IWL_HCMD_DFL_*
  * @id: command id of the host command, for wide commands encoding the
  *	version and group as well
+ * @seq: sequence number the response will carry, set by the transport
+ *	when the command is queued
  */
 struct iwl_host_cmd {
 	const void *data[IWL_MAX_CMD_TBS_PER_TFD];
@@ -236,6 +238,7 @@ struct iwl_host_cmd {
 	u32 id;
 	u16 len[IWL_MAX_CMD_TBS_PER_TFD];
 	u8 dataflags[IWL_MAX_CMD_TBS_PER_TFD];
+	u16 seq;
 };
 
 static inline void iwl_free_resp(struct iwl_host_cmd *cmd)
@@ -475,6 +478,25 @@ struct iwl_trans_rxq_dma_data {
 	u64 ur_bd_cb;
 };
 
+/**
+ * struct iwl_trans_rxq_stats - RX queue statistics
+ * @polls: number of times the queue was polled
+ * @rbs: number of RBs handled
+ * @budget_exhausted: number of polls that used up the whole budget
+ * @emergency: number of times the RX path ran out of allocated RBs
+ *	and entered the emergency path
+ * @page_steals: number of RBs whose page was passed up to the stack
+ * @rbs_in_use: number of RBs currently owned by the device
+ */
+struct iwl_trans_rxq_stats {
+	u64 polls;
+	u64 rbs;
+	u64 budget_exhausted;
+	u64 emergency;
+	u64 page_steals;
+	u32 rbs_in_use;
+};
+
 /* maximal number of DRAM MAP entries supported by FW */
 #define IPC_DRAM_MAP_ENTRY_NUM_MAX 64
 
@@ -539,6 +561,7 @@ struct iwl_pnvm_image {
  *	hardware scheduler bug. May sleep.
  * @txq_disable: de-configure a Tx queue to send AMPDUs
  *	Must be atomic
+ * @rxq_stats: get the statistics of an RX queue. Must be atomic
  * @txq_set_shared_mode: change Tx queue shared/unshared marking
  * @wait_tx_queues_empty: wait until tx queues are empty. May sleep.
  * @wait_txq_empty: wait until specific tx queue is empty. May sleep.
@@ -615,6 +638,8 @@ struct iwl_trans_ops {
 	void (*txq_free)(struct iwl_trans *trans, int queue);
 	int (*rxq_dma_data)(struct iwl_trans *trans, int queue,
 			    struct iwl_trans_rxq_dma_data *data);
+	int (*rxq_stats)(struct iwl_trans *trans, int queue,
+			 struct iwl_trans_rxq_stats *stats);
 
 	void (*txq_set_shared_mode)(struct iwl_trans *trans, u32 txq_id,
 				    bool shared);
@@ -805,6 +830,47 @@ struct iwl_imr_data {
 	__le64 imr_base_addr;
 };
 
+/**
+ * enum iwl_start_phase - timed phases of a device (re)start
+ * @IWL_START_PHASE_FW_REQUEST: requesting the firmware file
+ * @IWL_START_PHASE_FW_PARSE: parsing the firmware file TLVs
+ * @IWL_START_PHASE_OP_MODE_START: starting the op mode
+ * @IWL_START_PHASE_PNVM: loading the PNVM and reduce power images
+ * @IWL_START_PHASE_PAGING: setting up firmware paging
+ * @IWL_START_PHASE_NVM: reading and parsing the NVM
+ * @IWL_START_PHASE_FW_UP: loading and configuring the runtime firmware,
+ *	this includes the PNVM and paging phases of that load
+ * @IWL_START_PHASE_NUM: number of phases
+ */
+enum iwl_start_phase {
+	IWL_START_PHASE_FW_REQUEST,
+	IWL_START_PHASE_FW_PARSE,
+	IWL_START_PHASE_OP_MODE_START,
+	IWL_START_PHASE_PNVM,
+	IWL_START_PHASE_PAGING,
+	IWL_START_PHASE_NVM,
+	IWL_START_PHASE_FW_UP,
+	IWL_START_PHASE_NUM,
+};
+
+#define IWL_START_TIMING_HISTORY	8
+
+/**
+ * struct iwl_start_timing - phase durations of one device (re)start
+ * @begin: time the start began
+ * @end: time the last phase of this start completed
+ * @restart: this start is a recovery from a firmware error
+ * @usec: time spent in each &enum iwl_start_phase, in usec. A phase
+ *	that runs more than once (e.g. NVM on init and on restart) is
+ *	accumulated.
+ */
+struct iwl_start_timing {
+	ktime_t begin;
+	ktime_t end;
+	bool restart;
+	u32 usec[IWL_START_PHASE_NUM];
+};
+
 #define IWL_TRANS_CURRENT_PC_NAME_MAX_BYTES      32
 
 /**
@@ -904,6 +970,8 @@ struct iwl_cmd_meta {
 	struct iwl_host_cmd *source;
 	u32 flags;
 	u32 tbs;
+	/* TBs pointing into a (pre-mapped) TSO header page */
+	u32 tso_hdr_tbs;
 };
 
 /*
@@ -938,7 +1006,9 @@ struct iwl_pcie_first_tb_buf {
  *	for each command on the queue
  * @first_tb_dma: DMA address for the first_tb_bufs start
  * @entries: transmit entries (driver state)
- * @lock: queue lock
+ * @lock: queue lock, held by the producer (TX) side
+ * @reclaim_lock: serializes the consumer (reclaim/unmap) side; data queue
+ *	entries are freed holding only this lock, see iwl_txq_set_write_ptr()
  * @stuck_timer: timer that fires if queue gets stuck
  * @trans: pointer back to transport (for timer)
  * @need_update: indicates need to update read/write index
@@ -978,6 +1048,7 @@ struct iwl_txq {
 	struct iwl_pcie_txq_entry *entries;
 	/* lock for syncing changes on the queue */
 	spinlock_t lock;
+	spinlock_t reclaim_lock;
 	unsigned long frozen_expiry_remainder;
 	struct timer_list stuck_timer;
 	struct iwl_trans *trans;
@@ -1084,6 +1155,9 @@ struct iwl_trans_txqs {
  * @pcie_link_speed: current PCIe link speed (%PCI_EXP_LNKSTA_CLS_*),
  *	only valid for discrete (not integrated) NICs
  * @invalid_tx_cmd: invalid TX command buffer
+ * @start_timing: phase timing of the last %IWL_START_TIMING_HISTORY
+ *	device starts, used as a ring
+ * @start_timing_idx: index of the current entry in @start_timing
  * @reduced_cap_sku: reduced capability supported SKU
  * @no_160: device not supporting 160Mhz
  * @step_urm: STEP is in URM, no support for MCS>9 in 320 MHz
@@ -1163,12 +1237,19 @@ struct iwl_trans {
 
 	struct iwl_dma_ptr invalid_tx_cmd;
 
+	struct iwl_start_timing start_timing[IWL_START_TIMING_HISTORY];
+	u8 start_timing_idx;
+
 	/* pointer to trans specific struct */
 	/*Ensure that this pointer will always be aligned to sizeof pointer */
 	char trans_specific[] __aligned(sizeof(void *));
 };
 
 const char *iwl_get_cmd_string(struct iwl_trans *trans, u32 id);
+void iwl_trans_start_timing_begin(struct iwl_trans *trans, bool restart);
+void iwl_trans_start_phase_done(struct iwl_trans *trans,
+				enum iwl_start_phase phase, ktime_t begin);
+const char *iwl_trans_start_phase_name(enum iwl_start_phase phase);
 int iwl_cmd_groups_verify_sorted(const struct iwl_trans_config *trans);
 
 static inline void iwl_trans_configure(struct iwl_trans *trans,
@@ -1381,6 +1462,16 @@ iwl_trans_get_rxq_dma_data(struct iwl_trans *trans, int queue,
 	return trans->ops->rxq_dma_data(trans, queue, data);
 }
 
+static inline int
+iwl_trans_get_rxq_stats(struct iwl_trans *trans, int queue,
+			struct iwl_trans_rxq_stats *stats)
+{
+	if (!trans->ops->rxq_stats)
+		return -EOPNOTSUPP;
+
+	return trans->ops->rxq_stats(trans, queue, stats);
+}
+
 static inline void
 iwl_trans_txq_free(struct iwl_trans *trans, int queue)
 {
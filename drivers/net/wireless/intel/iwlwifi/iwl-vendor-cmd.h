@@ -116,6 +116,8 @@
  * @IWL_MVM_VENDOR_CMD_RFIM_GET_TABLE: Retrieve the RFIM table
  * @IWL_MVM_VENDOR_CMD_RFIM_GET_CAPA: Retrieve RFIM capabilities
  * @IWL_MVM_VENDOR_CMD_RFIM_SET_CNVI_MASTER: Set CNVI is master or not
+ * @IWL_MVM_VENDOR_CMD_TCM_EVENT: traffic load of a link changed. Contains a
+ *	&IWL_MVM_VENDOR_ATTR_TCM_LINKS attribute.
  */
 
 enum iwl_mvm_vendor_cmd {
@@ -172,6 +174,7 @@ enum iwl_mvm_vendor_cmd {
 	IWL_MVM_VENDOR_CMD_GEO_SAR_GET_TABLE                    = 0x35,
 	IWL_MVM_VENDOR_CMD_SGOM_GET_TABLE			= 0x36,
 	IWL_MVM_VENDOR_CMD_RFIM_SET_CNVI_MASTER			= 0x37,
+	IWL_MVM_VENDOR_CMD_TCM_EVENT				= 0x38,
 };
 
 /**
@@ -497,6 +500,32 @@ enum iwl_mvm_vendor_neighbor_report {
 		NUM_IWL_MVM_VENDOR_NEIGHBOR_REPORT - 1,
 };
 
+/**
+ * enum iwl_mvm_vendor_tcm_link - traffic condition of a link
+ *
+ * @__IWL_MVM_VENDOR_TCM_LINK_INVALID: attribute number 0 is reserved
+ * @IWL_MVM_VENDOR_TCM_LINK_ID: firmware link ID, or MAC ID for devices
+ *	without MLD support (u8)
+ * @IWL_MVM_VENDOR_TCM_LINK_LOAD: traffic load level, 0 (low) to 2 (high)
+ *	(u8)
+ * @IWL_MVM_VENDOR_TCM_LINK_AIRTIME: averaged airtime use in per mille,
+ *	an array of u32 indexed by the mac80211 AC (VO, VI, BE, BK)
+ * @IWL_MVM_VENDOR_TCM_LINK_PKT_RATE: averaged frames per second, an
+ *	array of u32 indexed by the mac80211 AC (VO, VI, BE, BK)
+ * @NUM_IWL_MVM_VENDOR_TCM_LINK: number of TCM link attributes
+ * @MAX_IWL_MVM_VENDOR_TCM_LINK: highest TCM link attribute number
+ */
+enum iwl_mvm_vendor_tcm_link {
+	__IWL_MVM_VENDOR_TCM_LINK_INVALID,
+	IWL_MVM_VENDOR_TCM_LINK_ID,
+	IWL_MVM_VENDOR_TCM_LINK_LOAD,
+	IWL_MVM_VENDOR_TCM_LINK_AIRTIME,
+	IWL_MVM_VENDOR_TCM_LINK_PKT_RATE,
+
+	NUM_IWL_MVM_VENDOR_TCM_LINK,
+	MAX_IWL_MVM_VENDOR_TCM_LINK = NUM_IWL_MVM_VENDOR_TCM_LINK - 1,
+};
+
 /**
  * enum iwl_vendor_sar_per_chain_geo_table - per chain tx power table
  *
@@ -799,6 +828,8 @@ enum iwl_vendor_auth_akm_mode {
  * @IWL_MVM_VENDOR_ATTR_RFIM_FREQ: RFIM frequency (u16)
  * @IWL_MVM_VENDOR_ATTR_RFIM_INFO: overall RFIM info (nested)
  * @IWL_MVM_VENDOR_ATTR_RFIM_CNVI_MASTER: CNVI master configuration (u32)
+ * @IWL_MVM_VENDOR_ATTR_TCM_LINKS: nested attribute. Contains a nested
+ *	attribute for each link, see &enum iwl_mvm_vendor_tcm_link.
  *
  * @NUM_IWL_MVM_VENDOR_ATTR: number of vendor attributes
  * @MAX_IWL_MVM_VENDOR_ATTR: highest vendor attribute number
@@ -915,6 +946,7 @@ enum iwl_mvm_vendor_attr {
 	IWL_MVM_VENDOR_ATTR_GEO_SAR_VER                         = 0x77,
 	IWL_MVM_VENDOR_ATTR_SGOM_TABLE				= 0x78,
 	IWL_MVM_VENDOR_ATTR_RFIM_CNVI_MASTER			= 0x79,
+	IWL_MVM_VENDOR_ATTR_TCM_LINKS				= 0x7a,
 
 	NUM_IWL_MVM_VENDOR_ATTR,
 	MAX_IWL_MVM_VENDOR_ATTR = NUM_IWL_MVM_VENDOR_ATTR - 1,
@@ -472,11 +472,12 @@ static void iwl_mvm_bt_notif_per_link(struct iwl_mvm *mvm,
 			data->secondary = chanctx_conf;
 		}
 
-		/* FIXME: TCM load per interface? or need something per link? */
 		if (data->primary == chanctx_conf)
-			data->primary_load = mvm->tcm.result.load[mvmvif->id];
+			data->primary_load =
+				iwl_mvm_tcm_link_load(mvm, mvmvif, link_info);
 		else if (data->secondary == chanctx_conf)
-			data->secondary_load = mvm->tcm.result.load[mvmvif->id];
+			data->secondary_load =
+				iwl_mvm_tcm_link_load(mvm, mvmvif, link_info);
 		return;
 	}
 
@@ -490,11 +491,12 @@ static void iwl_mvm_bt_notif_per_link(struct iwl_mvm *mvm,
 		/* if secondary is not NULL, it might be a GO */
 		data->secondary = chanctx_conf;
 
-	/* FIXME: TCM load per interface? or need something per link? */
 	if (data->primary == chanctx_conf)
-		data->primary_load = mvm->tcm.result.load[mvmvif->id];
+		data->primary_load =
+			iwl_mvm_tcm_link_load(mvm, mvmvif, link_info);
 	else if (data->secondary == chanctx_conf)
-		data->secondary_load = mvm->tcm.result.load[mvmvif->id];
+		data->secondary_load =
+			iwl_mvm_tcm_link_load(mvm, mvmvif, link_info);
 	/*
 	 * don't reduce the Tx power if one of these is true:
 	 *  we are in LOOSE
@@ -1556,6 +1556,140 @@ static ssize_t iwl_dbgfs_drv_rx_stats_read(struct file *file,
 					  &mvm->drv_rx_stats);
 }
 
+static ssize_t iwl_dbgfs_async_handlers_stats_read(struct file *file,
+						   char __user *user_buf,
+						   size_t count, loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_async_handlers_stats stats;
+	char buf[256];
+	int pos = 0;
+	const size_t bufsz = sizeof(buf);
+
+	spin_lock_bh(&mvm->async_handlers_lock);
+	stats = mvm->async_handlers_stats;
+	spin_unlock_bh(&mvm->async_handlers_lock);
+
+	pos += scnprintf(buf + pos, bufsz - pos, "pool size:\t%u\n",
+			 IWL_MVM_ASYNC_HANDLERS_POOL_SIZE);
+	pos += scnprintf(buf + pos, bufsz - pos, "in use:\t\t%u\n",
+			 stats.in_use);
+	pos += scnprintf(buf + pos, bufsz - pos, "high-water mark:\t%u\n",
+			 stats.hwm);
+	pos += scnprintf(buf + pos, bufsz - pos, "reserve size:\t%u\n",
+			 IWL_MVM_ASYNC_HANDLERS_RESERVE);
+	pos += scnprintf(buf + pos, bufsz - pos, "reserve used:\t%u\n",
+			 stats.reserve_used);
+	pos += scnprintf(buf + pos, bufsz - pos, "fallbacks:\t%u\n",
+			 stats.fallbacks);
+	pos += scnprintf(buf + pos, bufsz - pos, "drops:\t\t%u\n",
+			 stats.drops);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+static ssize_t iwl_dbgfs_lq_stats_read(struct file *file,
+				       char __user *user_buf,
+				       size_t count, loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	u32 requested = atomic_read(&mvm->lq_flush.requested);
+	u32 sent = READ_ONCE(mvm->lq_flush.sent);
+	unsigned long msecs;
+	char buf[160];
+	int pos = 0;
+	const size_t bufsz = sizeof(buf);
+
+	msecs = jiffies_to_msecs(jiffies - mvm->lq_flush.since) ?: 1;
+
+	pos += scnprintf(buf + pos, bufsz - pos, "requested:\t%u\n",
+			 requested);
+	pos += scnprintf(buf + pos, bufsz - pos, "sent:\t\t%u\n", sent);
+	pos += scnprintf(buf + pos, bufsz - pos, "sent per sec:\t%llu\n",
+			 div_u64((u64)sent * MSEC_PER_SEC, msecs));
+	pos += scnprintf(buf + pos, bufsz - pos, "coalesced:\t%u%%\n",
+			 requested ? 100 - sent * 100 / requested : 0);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+static ssize_t iwl_dbgfs_lq_stats_write(struct iwl_mvm *mvm, char *buf,
+					size_t count, loff_t *ppos)
+{
+	atomic_set(&mvm->lq_flush.requested, 0);
+	WRITE_ONCE(mvm->lq_flush.sent, 0);
+	mvm->lq_flush.since = jiffies;
+
+	return count;
+}
+
+static ssize_t iwl_dbgfs_tcm_read(struct file *file, char __user *user_buf,
+				  size_t count, loff_t *ppos)
+{
+	static const char * const ac_names[IEEE80211_NUM_ACS] = {
+		[IEEE80211_AC_VO] = "VO",
+		[IEEE80211_AC_VI] = "VI",
+		[IEEE80211_AC_BE] = "BE",
+		[IEEE80211_AC_BK] = "BK",
+	};
+	struct iwl_mvm *mvm = file->private_data;
+	const size_t bufsz = 1024;
+	int i, ac, pos = 0;
+	ssize_t ret;
+	char *buf;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	spin_lock_bh(&mvm->tcm.lock);
+	pos += scnprintf(buf + pos, bufsz - pos, "period: %u msec\n",
+			 jiffies_to_msecs(mvm->tcm.period));
+	pos += scnprintf(buf + pos, bufsz - pos, "global load: %d\n",
+			 mvm->tcm.result.global_load);
+	for (i = 0; i < ARRAY_SIZE(mvm->tcm.link); i++) {
+		struct iwl_mvm_tcm_link *ldata = &mvm->tcm.link[i];
+
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "link %d: load %d\n\tAC\tairtime\tpkts/sec\n",
+				 i, mvm->tcm.result.link_load[i]);
+		for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+			struct ewma_tcm *airtime = &ldata->airtime_avg[ac];
+			struct ewma_tcm *pkt_rate = &ldata->pkt_rate_avg[ac];
+
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\t%s\t%lu\t%lu\n", ac_names[ac],
+					 ewma_tcm_read(airtime),
+					 ewma_tcm_read(pkt_rate));
+		}
+	}
+	spin_unlock_bh(&mvm->tcm.lock);
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+	return ret;
+}
+
+static ssize_t iwl_dbgfs_tcm_write(struct iwl_mvm *mvm, char *buf,
+				   size_t count, loff_t *ppos)
+{
+	u32 period;
+	int ret;
+
+	ret = kstrtou32(buf, 0, &period);
+	if (ret)
+		return ret;
+
+	if (period < 10 || period > 10000)
+		return -EINVAL;
+
+	spin_lock_bh(&mvm->tcm.lock);
+	mvm->tcm.period = msecs_to_jiffies(period);
+	spin_unlock_bh(&mvm->tcm.lock);
+
+	return count;
+}
+
 static ssize_t iwl_dbgfs_fw_restart_write(struct iwl_mvm *mvm, char *buf,
 					  size_t count, loff_t *ppos)
 {
@@ -2661,6 +2795,9 @@ MVM_DEBUGFS_READ_FILE_OPS(bt_cmd);
 MVM_DEBUGFS_READ_WRITE_FILE_OPS(disable_power_off, 64);
 MVM_DEBUGFS_READ_FILE_OPS(fw_rx_stats);
 MVM_DEBUGFS_READ_FILE_OPS(drv_rx_stats);
+MVM_DEBUGFS_READ_FILE_OPS(async_handlers_stats);
+MVM_DEBUGFS_READ_WRITE_FILE_OPS(lq_stats, 8);
+MVM_DEBUGFS_READ_WRITE_FILE_OPS(tcm, 16);
 MVM_DEBUGFS_READ_FILE_OPS(fw_system_stats);
 MVM_DEBUGFS_READ_FILE_OPS(fw_ver);
 MVM_DEBUGFS_READ_FILE_OPS(phy_integration_ver);
@@ -2896,6 +3033,9 @@ void iwl_mvm_dbgfs_register(struct iwl_mvm *mvm)
 	MVM_DEBUGFS_ADD_FILE(fw_ver, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(fw_rx_stats, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(drv_rx_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(async_handlers_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(lq_stats, mvm->debugfs_dir, 0600);
+	MVM_DEBUGFS_ADD_FILE(tcm, mvm->debugfs_dir, 0600);
 	MVM_DEBUGFS_ADD_FILE(fw_system_stats, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(fw_restart, mvm->debugfs_dir, 0200);
 	MVM_DEBUGFS_ADD_FILE(fw_nmi, mvm->debugfs_dir, 0200);
@@ -326,6 +326,7 @@ static int iwl_mvm_load_ucode_wait_alive(struct iwl_mvm *mvm,
 	struct iwl_notification_wait alive_wait;
 	struct iwl_mvm_alive_data alive_data = {};
 	const struct fw_img *fw;
+	ktime_t start;
 	int ret;
 	enum iwl_ucode_type old_type = mvm->fwrt.cur_fw_img;
 	static const u16 alive_cmd[] = { UCODE_ALIVE_NTFY };
@@ -443,8 +444,10 @@ static int iwl_mvm_load_ucode_wait_alive(struct iwl_mvm *mvm,
 	/* if reached this point, Alive notification was received */
 	iwl_mei_alive_notif(true);
 
+	start = ktime_get();
 	ret = iwl_pnvm_load(mvm->trans, &mvm->notif_wait,
 			    &mvm->fw->ucode_capa);
+	iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_PNVM, start);
 	if (ret) {
 		IWL_ERR(mvm, "Timeout waiting for PNVM load!\n");
 		iwl_fw_set_current_image(&mvm->fwrt, old_type);
@@ -734,6 +737,7 @@ static int iwl_run_unified_mvm_ucode(struct iwl_mvm *mvm)
 		INIT_COMPLETE_NOTIF,
 	};
 	u32 sb_cfg;
+	ktime_t start;
 	int ret;
 
 	if (mvm->trans->cfg->tx_with_siso_diversity)
@@ -806,7 +810,10 @@ static int iwl_run_unified_mvm_ucode(struct iwl_mvm *mvm)
 	}
 
 	if (IWL_MVM_PARSE_NVM && !mvm->nvm_data) {
+		start = ktime_get();
 		ret = iwl_nvm_init(mvm);
+		iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_NVM,
+					   start);
 		if (ret) {
 			IWL_ERR(mvm, "Failed to read NVM: %d\n", ret);
 			goto error;
@@ -838,8 +845,11 @@ static int iwl_run_unified_mvm_ucode(struct iwl_mvm *mvm)
 
 	/* Read the NVM only at driver load time, no need to do this twice */
 	if (!IWL_MVM_PARSE_NVM && !mvm->nvm_data) {
+		start = ktime_get();
 		mvm->nvm_data = iwl_get_nvm(mvm->trans, mvm->fw,
 					    mvm->set_tx_ant, mvm->set_rx_ant);
+		iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_NVM,
+					   start);
 		if (IS_ERR(mvm->nvm_data)) {
 			ret = PTR_ERR(mvm->nvm_data);
 			mvm->nvm_data = NULL;
@@ -865,6 +875,7 @@ int iwl_run_init_mvm_ucode(struct iwl_mvm *mvm)
 		INIT_COMPLETE_NOTIF,
 		CALIB_RES_NOTIF_PHY_DB
 	};
+	ktime_t start;
 	int ret;
 
 	if (iwl_mvm_has_unified_ucode(mvm))
@@ -901,7 +912,10 @@ int iwl_run_init_mvm_ucode(struct iwl_mvm *mvm)
 
 	/* Read the NVM only at driver load time, no need to do this twice */
 	if (!mvm->nvm_data) {
+		start = ktime_get();
 		ret = iwl_nvm_init(mvm);
+		iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_NVM,
+					   start);
 		if (ret) {
 			IWL_ERR(mvm, "Failed to read NVM: %d\n", ret);
 			goto remove_notif;
@@ -1597,6 +1611,7 @@ static int iwl_mvm_sar_init(struct iwl_mvm *mvm)
 
 static int iwl_mvm_load_rt_fw(struct iwl_mvm *mvm)
 {
+	ktime_t start;
 	int ret;
 
 	if (iwl_mvm_has_unified_ucode(mvm))
@@ -1628,7 +1643,11 @@ static int iwl_mvm_load_rt_fw(struct iwl_mvm *mvm)
 	iwl_dbg_tlv_time_point(&mvm->fwrt, IWL_FW_INI_TIME_POINT_AFTER_ALIVE,
 			       NULL);
 
-	return iwl_init_paging(&mvm->fwrt, mvm->fwrt.cur_fw_img);
+	start = ktime_get();
+	ret = iwl_init_paging(&mvm->fwrt, mvm->fwrt.cur_fw_img);
+	iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_PAGING, start);
+
+	return ret;
 }
 
 #ifdef CPTCFG_IWLWIFI_SUPPORT_DEBUG_OVERRIDES
@@ -67,6 +67,7 @@ int iwl_mvm_add_link(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
 
 		rcu_assign_pointer(mvm->link_id_to_link_conf[link_info->fw_link_id],
 				   link_conf);
+		iwl_mvm_tcm_reset_link(mvm, link_info->fw_link_id);
 	}
 
 	/* Update SF - Disable if needed. if this fails, SF might still be on
@@ -1258,6 +1258,7 @@ static void iwl_mvm_restart_cleanup(struct iwl_mvm *mvm)
 
 int __iwl_mvm_mac_start(struct iwl_mvm *mvm)
 {
+	ktime_t start;
 	int ret;
 
 	lockdep_assert_held(&mvm->mutex);
@@ -1292,8 +1293,13 @@ int __iwl_mvm_mac_start(struct iwl_mvm *mvm)
 		clear_bit(IWL_MVM_STATUS_HW_RESTART_REQUESTED, &mvm->status);
 		/* Clean up some internal and mac80211 state on restart */
 		iwl_mvm_restart_cleanup(mvm);
+	} else {
+		iwl_trans_start_timing_begin(mvm->trans, false);
 	}
+
+	start = ktime_get();
 	ret = iwl_mvm_up(mvm);
+	iwl_trans_start_phase_done(mvm->trans, IWL_START_PHASE_FW_UP, start);
 
 	iwl_dbg_tlv_time_point(&mvm->fwrt, IWL_FW_INI_TIME_POINT_POST_INIT,
 			       NULL);
@@ -1451,6 +1457,8 @@ void iwl_mvm_mac_stop(struct ieee80211_hw *hw)
 
 	cancel_delayed_work_sync(&mvm->cs_tx_unblock_dwork);
 	cancel_delayed_work_sync(&mvm->scan_timeout_dwork);
+	cancel_delayed_work_sync(&mvm->lq_flush.wk);
+	bitmap_zero(mvm->lq_flush.dirty, IWL_MVM_STATION_COUNT_MAX);
 
 	/*
 	 * The work item could be running or queued if the
@@ -6239,6 +6247,76 @@ void iwl_mvm_mac_sta_statistics(struct ieee80211_hw *hw,
 	mutex_unlock(&mvm->mutex);
 }
 
+static const char iwl_mvm_et_rxq_stats[][ETH_GSTRING_LEN] = {
+	"polls",
+	"rbs",
+	"budget_exhausted",
+	"emergency",
+	"page_steals",
+	"rbs_in_use",
+};
+
+#define IWL_MVM_ET_RXQ_STATS_LEN ARRAY_SIZE(iwl_mvm_et_rxq_stats)
+
+int iwl_mvm_mac_get_et_sset_count(struct ieee80211_hw *hw,
+				  struct ieee80211_vif *vif, int sset)
+{
+	struct iwl_mvm *mvm = IWL_MAC80211_GET_MVM(hw);
+
+	if (sset != ETH_SS_STATS || !mvm->trans->ops->rxq_stats)
+		return 0;
+
+	return mvm->trans->num_rx_queues * IWL_MVM_ET_RXQ_STATS_LEN;
+}
+
+void iwl_mvm_mac_get_et_strings(struct ieee80211_hw *hw,
+				struct ieee80211_vif *vif,
+				u32 sset, u8 *data)
+{
+	struct iwl_mvm *mvm = IWL_MAC80211_GET_MVM(hw);
+	int q, i;
+
+	if (sset != ETH_SS_STATS || !mvm->trans->ops->rxq_stats)
+		return;
+
+	for (q = 0; q < mvm->trans->num_rx_queues; q++) {
+		for (i = 0; i < IWL_MVM_ET_RXQ_STATS_LEN; i++) {
+			snprintf(data, ETH_GSTRING_LEN, "rxq%d_%s", q,
+				 iwl_mvm_et_rxq_stats[i]);
+			data += ETH_GSTRING_LEN;
+		}
+	}
+}
+
+void iwl_mvm_mac_get_et_stats(struct ieee80211_hw *hw,
+			      struct ieee80211_vif *vif,
+			      struct ethtool_stats *stats, u64 *data)
+{
+	struct iwl_mvm *mvm = IWL_MAC80211_GET_MVM(hw);
+	int q;
+
+	if (!mvm->trans->ops->rxq_stats)
+		return;
+
+	for (q = 0; q < mvm->trans->num_rx_queues; q++) {
+		struct iwl_trans_rxq_stats rxq_stats = {};
+		int i = 0;
+
+		/* the queues may not be allocated yet, report zeros then */
+		iwl_trans_get_rxq_stats(mvm->trans, q, &rxq_stats);
+
+		data[i++] = rxq_stats.polls;
+		data[i++] = rxq_stats.rbs;
+		data[i++] = rxq_stats.budget_exhausted;
+		data[i++] = rxq_stats.emergency;
+		data[i++] = rxq_stats.page_steals;
+		data[i++] = rxq_stats.rbs_in_use;
+
+		WARN_ON(i != IWL_MVM_ET_RXQ_STATS_LEN);
+		data += IWL_MVM_ET_RXQ_STATS_LEN;
+	}
+}
+
 static void iwl_mvm_event_mlme_callback_ini(struct iwl_mvm *mvm,
 					    struct ieee80211_vif *vif,
 					    const  struct ieee80211_mlme_event *mlme)
@@ -6611,6 +6689,9 @@ const struct ieee80211_ops iwl_mvm_hw_ops = {
 #endif
 	.get_survey = iwl_mvm_mac_get_survey,
 	.sta_statistics = iwl_mvm_mac_sta_statistics,
+	.get_et_sset_count = iwl_mvm_mac_get_et_sset_count,
+	.get_et_strings = iwl_mvm_mac_get_et_strings,
+	.get_et_stats = iwl_mvm_mac_get_et_stats,
 	.get_ftm_responder_stats = iwl_mvm_mac_get_ftm_responder_stats,
 	.start_pmsr = iwl_mvm_start_pmsr,
 	.abort_pmsr = iwl_mvm_abort_pmsr,
@@ -1465,6 +1465,9 @@ const struct ieee80211_ops iwl_mvm_mld_hw_ops = {
 #endif
 	.get_survey = iwl_mvm_mac_get_survey,
 	.sta_statistics = iwl_mvm_mac_sta_statistics,
+	.get_et_sset_count = iwl_mvm_mac_get_et_sset_count,
+	.get_et_strings = iwl_mvm_mac_get_et_strings,
+	.get_et_stats = iwl_mvm_mac_get_et_stats,
 	.get_ftm_responder_stats = iwl_mvm_mac_get_ftm_responder_stats,
 	.start_pmsr = iwl_mvm_start_pmsr,
 	.abort_pmsr = iwl_mvm_abort_pmsr,
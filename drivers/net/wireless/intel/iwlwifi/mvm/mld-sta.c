@@ -670,7 +670,7 @@ static int iwl_mvm_alloc_sta_after_restart(struct iwl_mvm *mvm,
 		ret = 0;
 	}
 
-	iwl_mvm_realloc_queues_after_restart(mvm, sta);
+	iwl_mvm_realloc_queues_after_restart(mvm, sta, NULL);
 
 	return ret;
 }
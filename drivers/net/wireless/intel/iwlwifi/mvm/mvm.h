@@ -629,14 +629,38 @@ struct iwl_mvm_tcm_mac {
 	bool opened_rx_ba_sessions;
 };
 
+DECLARE_EWMA(tcm, 8, 4)
+
+#define IWL_MVM_TCM_NUM_LINKS	(IWL_MVM_FW_MAX_LINK_ID + 1)
+
+/**
+ * struct iwl_mvm_tcm_link - per-link traffic condition monitor data
+ * @pkts: TX and RX frames in the current period, per AC
+ * @airtime: TX and RX airtime (usec) in the current period, per AC
+ * @airtime_avg: moving average of the airtime, in per mille of the
+ *	period, per AC
+ * @pkt_rate_avg: moving average of the frame rate (per second), per AC
+ *
+ * With the MLD API this is indexed by the firmware link ID, otherwise
+ * each MAC has a single link and this is indexed by the MAC ID.
+ */
+struct iwl_mvm_tcm_link {
+	u32 pkts[IEEE80211_NUM_ACS];
+	u32 airtime[IEEE80211_NUM_ACS];
+	struct ewma_tcm airtime_avg[IEEE80211_NUM_ACS];
+	struct ewma_tcm pkt_rate_avg[IEEE80211_NUM_ACS];
+};
+
 struct iwl_mvm_tcm {
 	struct delayed_work work;
 	spinlock_t lock; /* used when time elapsed */
 	unsigned long ts; /* timestamp when period ends */
 	unsigned long ll_ts;
 	unsigned long uapsd_nonagg_ts;
+	unsigned long period; /* jiffies */
 	bool paused;
 	struct iwl_mvm_tcm_mac data[NUM_MAC_INDEX_DRIVER];
+	struct iwl_mvm_tcm_link link[IWL_MVM_TCM_NUM_LINKS];
 	struct {
 		u32 elapsed; /* milliseconds for this TCM period */
 		u32 airtime[NUM_MAC_INDEX_DRIVER];
@@ -645,6 +669,8 @@ struct iwl_mvm_tcm {
 		enum iwl_mvm_traffic_load global_load;
 		bool low_latency[NUM_MAC_INDEX_DRIVER];
 		bool change[NUM_MAC_INDEX_DRIVER];
+		enum iwl_mvm_traffic_load link_load[IWL_MVM_TCM_NUM_LINKS];
+		bool link_change[IWL_MVM_TCM_NUM_LINKS];
 	} result;
 };
 
@@ -675,6 +701,8 @@ struct iwl_mvm_tdls_peer_counter {
  * @valid: reordering is valid for this queue
  * @lock: protect reorder buffer internal state
  * @mvm: mvm pointer, needed for frame timer context
+ * @entries: frames stored per slot (sn % @buf_size)
+ * @stored: bitmap of the slots in @entries that hold frames, @buf_size bits
  */
 struct iwl_mvm_reorder_buffer {
 	u16 head_sn;
@@ -686,36 +714,22 @@ struct iwl_mvm_reorder_buffer {
 	bool valid;
 	spinlock_t lock;
 	struct iwl_mvm *mvm;
+	struct sk_buff_head *entries;
+	unsigned long *stored;
 } ____cacheline_aligned_in_smp;
 
-/**
- * struct iwl_mvm_reorder_buf_entry - reorder buffer entry per-queue/per-seqno
- * @frames: list of skbs stored
- */
-struct iwl_mvm_reorder_buf_entry {
-	struct sk_buff_head frames;
-}
-#ifndef __CHECKER__
-/* sparse doesn't like this construct: "bad integer constant expression" */
-__aligned(roundup_pow_of_two(sizeof(struct sk_buff_head)))
-#endif
-;
-
 /**
  * struct iwl_mvm_baid_data - BA session data
  * @sta_mask: current station mask for the BAID
  * @tid: tid of the session
  * @baid: baid of the session
  * @timeout: the timeout set in the addba request
- * @entries_per_queue: # of buffers per queue, this actually gets
- *	aligned up to avoid cache line sharing between queues
  * @last_rx: last rx jiffies, updated only if timeout passed from last update
  * @session_timer: timer to check if BA session expired, runs at 2 * timeout
  * @rcu_ptr: BA data RCU protected access
  * @rcu_head: RCU head for freeing this data
  * @mvm: mvm pointer, needed for timer context
  * @reorder_buf: reorder buffer, allocated per queue
- * @entries: data
  */
 struct iwl_mvm_baid_data {
 	struct rcu_head rcu_head;
@@ -723,13 +737,11 @@ struct iwl_mvm_baid_data {
 	u8 tid;
 	u8 baid;
 	u16 timeout;
-	u16 entries_per_queue;
 	unsigned long last_rx;
 	struct timer_list session_timer;
 	struct iwl_mvm_baid_data __rcu **rcu_ptr;
 	struct iwl_mvm *mvm;
 	struct iwl_mvm_reorder_buffer reorder_buf[IWL_MAX_RX_HW_QUEUES];
-	struct iwl_mvm_reorder_buf_entry entries[];
 };
 
 static inline struct iwl_mvm_baid_data *
@@ -828,6 +840,95 @@ struct iwl_csi_data_buffer {
 };
 #endif
 
+/**
+ * enum iwl_rx_handler_context: context for Rx handler
+ * @RX_HANDLER_SYNC : this means that it will be called in the Rx path
+ *	which can't acquire mvm->mutex.
+ * @RX_HANDLER_ASYNC_LOCKED : If the handler needs to hold mvm->mutex
+ *	(and only in this case!), it should be set as ASYNC. In that case,
+ *	it will be called from a worker with mvm->mutex held.
+ * @RX_HANDLER_ASYNC_UNLOCKED : in case the handler needs to lock the
+ *	mutex itself, it will be called from a worker without mvm->mutex held.
+ * @RX_HANDLER_ASYNC_LOCKED_WIPHY: If the handler needs to hold the wiphy lock
+ *	and mvm->mutex. Will be handled with the wiphy_work queue infra
+ *	instead of regular work queue.
+ */
+enum iwl_rx_handler_context {
+	RX_HANDLER_SYNC,
+	RX_HANDLER_ASYNC_LOCKED,
+	RX_HANDLER_ASYNC_UNLOCKED,
+	RX_HANDLER_ASYNC_LOCKED_WIPHY,
+};
+
+/**
+ * struct iwl_rx_handlers: handler for FW notification
+ * @cmd_id: command id
+ * @min_size: minimum size to expect for the notification
+ * @context: see &iwl_rx_handler_context
+ * @fn: the function is called when notification is received
+ */
+struct iwl_rx_handlers {
+	u16 cmd_id, min_size;
+	enum iwl_rx_handler_context context;
+	void (*fn)(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
+};
+
+#define IWL_MVM_RX_HANDLER_GROUPS	(STATISTICS_GROUP + 1)
+
+/* number of preallocated entries for async notification handlers */
+#define IWL_MVM_ASYNC_HANDLERS_POOL_SIZE	64
+/* entries kept aside for when the pool is exhausted */
+#define IWL_MVM_ASYNC_HANDLERS_RESERVE		16
+
+struct iwl_async_handler_entry;
+
+/**
+ * struct iwl_mvm_async_handlers_stats - async handler entry pool statistics
+ * @in_use: number of entries currently queued
+ * @hwm: high-water mark of @in_use
+ * @reserve_used: number of entries taken from the reserve because the
+ *	pool was empty
+ * @fallbacks: number of entries allocated because both the pool and the
+ *	reserve were empty
+ * @drops: number of notifications dropped because even the fallback
+ *	allocation failed
+ */
+struct iwl_mvm_async_handlers_stats {
+	u32 in_use;
+	u32 hwm;
+	u32 reserve_used;
+	u32 fallbacks;
+	u32 drops;
+};
+
+/**
+ * struct iwl_mvm_lq_flush - coalescing of driver rate scaling LQ commands
+ * @wk: sends the LQ command of the stations marked in @dirty
+ * @dirty: stations whose LQ command changed since it was last sent
+ * @requested: number of LQ command updates requested by rate scaling
+ * @sent: number of LQ commands actually sent for them
+ * @since: time (in jiffies) the counters were last reset
+ */
+struct iwl_mvm_lq_flush {
+	struct delayed_work wk;
+	unsigned long dirty[BITS_TO_LONGS(IWL_MVM_STATION_COUNT_MAX)];
+	atomic_t requested;
+	u32 sent;
+	unsigned long since;
+};
+
+/**
+ * struct iwl_mvm_rx_handler_map - notification ID to handler lookup
+ * @handlers: the handler table the map was built from
+ * @grp: per group ID, an array indexed by the command ID holding the
+ *	handler index + 1 (0 means no handler), or %NULL if no handler
+ *	exists for any command in that group
+ */
+struct iwl_mvm_rx_handler_map {
+	const struct iwl_rx_handlers *handlers;
+	u8 *grp[IWL_MVM_RX_HANDLER_GROUPS];
+};
+
 struct iwl_time_sync_data {
 	struct sk_buff_head frame_list;
 	u8 peer_addr[ETH_ALEN];
@@ -853,6 +954,30 @@ struct iwl_mvm {
 	/* For async rx handlers that require the wiphy lock */
 	struct wiphy_work async_handlers_wiphy_wk;
 
+	/* notification handler lookup, built at op-mode start */
+	struct iwl_mvm_rx_handler_map rx_handler_map;
+
+	/*
+	 * Preallocated entries for async notification handlers, so that the
+	 * RX path doesn't have to allocate, and a reserve used only when the
+	 * pool runs out. Protected by async_handlers_lock.
+	 */
+	struct iwl_async_handler_entry *async_handlers_pool;
+	struct list_head async_handlers_free;
+	struct list_head async_handlers_reserve;
+	unsigned int async_handlers_reserve_len;
+	struct iwl_mvm_async_handlers_stats async_handlers_stats;
+
+	/*
+	 * Frames processed by mac80211 during the current NAPI poll of each
+	 * RX queue, handed to GRO together once the poll is done.
+	 */
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+	struct list_head rx_batch[IWL_MAX_RX_HW_QUEUES];
+#else
+	struct sk_buff_head rx_batch[IWL_MAX_RX_HW_QUEUES];
+#endif
+
 	struct work_struct roc_done_wk;
 
 	unsigned long init_status;
@@ -1217,6 +1342,9 @@ struct iwl_mvm {
 
 	struct delayed_work cs_tx_unblock_dwork;
 
+	/* deferred LQ commands of the driver rate scaling */
+	struct iwl_mvm_lq_flush lq_flush;
+
 	/* does a monitor vif exist (only one can exist hence bool) */
 	bool monitor_on;
 	/* primary channel place relative the whole bandwidth in gaps of 80Mhz */
@@ -1695,6 +1823,56 @@ int __must_check iwl_mvm_send_cmd_status(struct iwl_mvm *mvm,
 int __must_check iwl_mvm_send_cmd_pdu_status(struct iwl_mvm *mvm, u32 id,
 					     u16 len, const void *data,
 					     u32 *status);
+
+#define IWL_MVM_CMD_BATCH_MAX_RESP	8
+
+/**
+ * struct iwl_mvm_cmd_batch - pipelined host commands
+ *
+ * The commands of a batch are queued asynchronously, back to back, and
+ * iwl_mvm_cmd_batch_finish() waits for all of them at once with a single
+ * synchronous command, instead of a round trip per command.
+ *
+ * @mvm: the mvm the commands are sent to
+ * @wait: notification wait used to collect the responses
+ * @lock: protects @resp against the RX path
+ * @resp: commands whose response is handed to a callback
+ * @resp.seq: sequence number of the command
+ * @resp.fn: called from the RX path with the response, a non-zero
+ *	return value fails the batch with that error
+ * @resp.data: passed to @resp.fn
+ * @n_resp: number of valid entries in @resp
+ * @ret: the first error of the batch
+ */
+struct iwl_mvm_cmd_batch {
+	struct iwl_mvm *mvm;
+	struct iwl_notification_wait wait;
+	spinlock_t lock;
+	struct {
+		u16 seq;
+		int (*fn)(struct iwl_mvm *mvm, struct iwl_rx_packet *pkt,
+			  void *data);
+		void *data;
+	} resp[IWL_MVM_CMD_BATCH_MAX_RESP];
+	u8 n_resp;
+	int ret;
+};
+
+void iwl_mvm_cmd_batch_init(struct iwl_mvm *mvm,
+			    struct iwl_mvm_cmd_batch *batch,
+			    const u16 *resp_cmds, int n_resp_cmds);
+int iwl_mvm_cmd_batch_add(struct iwl_mvm_cmd_batch *batch,
+			  struct iwl_host_cmd *cmd,
+			  int (*fn)(struct iwl_mvm *mvm,
+				    struct iwl_rx_packet *pkt, void *data),
+			  void *data);
+int iwl_mvm_cmd_batch_add_pdu(struct iwl_mvm_cmd_batch *batch, u32 id,
+			      u32 flags, u16 len, const void *data,
+			      int (*fn)(struct iwl_mvm *mvm,
+					struct iwl_rx_packet *pkt,
+					void *fn_data),
+			      void *fn_data);
+int iwl_mvm_cmd_batch_finish(struct iwl_mvm_cmd_batch *batch);
 int iwl_mvm_tx_skb_sta(struct iwl_mvm *mvm, struct sk_buff *skb,
 		       struct ieee80211_sta *sta);
 int iwl_mvm_tx_skb_non_sta(struct iwl_mvm *mvm, struct sk_buff *skb);
@@ -1731,6 +1909,18 @@ int iwl_mvm_set_sta_pkt_ext(struct iwl_mvm *mvm,
 
 void iwl_mvm_async_handlers_purge(struct iwl_mvm *mvm);
 
+int iwl_mvm_rx_handler_map_init(struct iwl_mvm_rx_handler_map *map,
+				const struct iwl_rx_handlers *handlers,
+				int n_handlers);
+void iwl_mvm_rx_handler_map_free(struct iwl_mvm_rx_handler_map *map);
+const struct iwl_rx_handlers *
+iwl_mvm_rx_handler_map_lookup(const struct iwl_mvm_rx_handler_map *map,
+			      u16 cmd_id);
+#if IS_ENABLED(CPTCFG_IWLWIFI_KUNIT_TESTS)
+extern const struct iwl_rx_handlers iwl_mvm_rx_handlers[];
+extern const unsigned int iwl_mvm_rx_handlers_size;
+#endif
+
 static inline void iwl_mvm_set_tx_cmd_ccmp(struct ieee80211_tx_info *info,
 					   struct iwl_tx_cmd *tx_cmd)
 {
@@ -1837,6 +2027,18 @@ void iwl_mvm_rx_bar_frame_release(struct iwl_mvm *mvm, struct napi_struct *napi,
 				  struct iwl_rx_cmd_buffer *rxb, int queue);
 void iwl_mvm_rx_queue_notif(struct iwl_mvm *mvm, struct napi_struct *napi,
 			    struct iwl_rx_cmd_buffer *rxb, int queue);
+void iwl_mvm_rx_batch_flush(struct iwl_mvm *mvm, struct napi_struct *napi,
+			    int queue);
+#if IS_ENABLED(CPTCFG_IWLWIFI_KUNIT_TESTS)
+void iwl_mvm_reorder_buf_store(struct iwl_mvm_reorder_buffer *buf, u16 sn,
+			       struct sk_buff *skb);
+void iwl_mvm_reorder_buf_release(struct iwl_mvm_reorder_buffer *buf, u16 nssn,
+				 struct sk_buff_head *frames);
+#ifdef CONFIG_INET
+int iwl_mvm_tx_tso_split(struct sk_buff *skb, unsigned int num_subframes,
+			 struct sk_buff_head *mpdus_skb);
+#endif
+#endif
 void iwl_mvm_rx_tx_cmd(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
 void iwl_mvm_mfu_assert_dump_notif(struct iwl_mvm *mvm,
 				   struct iwl_rx_cmd_buffer *rxb);
@@ -2401,8 +2603,6 @@ struct ieee80211_vif *iwl_mvm_get_bss_vif(struct iwl_mvm *mvm);
 struct ieee80211_vif *iwl_mvm_get_vif_by_macid(struct iwl_mvm *mvm, u32 macid);
 bool iwl_mvm_is_vif_assoc(struct iwl_mvm *mvm);
 
-#define MVM_TCM_PERIOD_MSEC 500
-#define MVM_TCM_PERIOD (HZ * MVM_TCM_PERIOD_MSEC / 1000)
 #define MVM_LL_PERIOD (10 * HZ)
 void iwl_mvm_tcm_work(struct work_struct *work);
 void iwl_mvm_recalc_tcm(struct iwl_mvm *mvm);
@@ -2410,8 +2610,22 @@ void iwl_mvm_pause_tcm(struct iwl_mvm *mvm, bool with_cancel);
 void iwl_mvm_resume_tcm(struct iwl_mvm *mvm);
 void iwl_mvm_tcm_add_vif(struct iwl_mvm *mvm, struct ieee80211_vif *vif);
 void iwl_mvm_tcm_rm_vif(struct iwl_mvm *mvm, struct ieee80211_vif *vif);
+void iwl_mvm_tcm_reset_link(struct iwl_mvm *mvm, unsigned int idx);
+enum iwl_mvm_traffic_load
+iwl_mvm_tcm_link_load(struct iwl_mvm *mvm, struct iwl_mvm_vif *mvmvif,
+		      struct iwl_mvm_vif_link_info *link_info);
 u8 iwl_mvm_tcm_load_percentage(u32 airtime, u32 elapsed);
 
+static inline unsigned int
+iwl_mvm_tcm_link_idx(struct iwl_mvm *mvm, struct iwl_mvm_vif *mvmvif,
+		     struct iwl_mvm_vif_link_info *link_info)
+{
+	if (iwl_mvm_has_mld_api(mvm->fw))
+		return link_info->fw_link_id;
+
+	return mvmvif->id;
+}
+
 void iwl_mvm_nic_restart(struct iwl_mvm *mvm, bool fw_error);
 unsigned int iwl_mvm_get_wd_timeout(struct iwl_mvm *mvm,
 				    struct ieee80211_vif *vif,
@@ -2431,6 +2645,7 @@ void iwl_mvm_active_rx_filters(struct iwl_mvm *mvm);
 void iwl_mvm_rx_csi_header(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
 void iwl_mvm_rx_csi_chunk(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
 int iwl_mvm_send_csi_cmd(struct iwl_mvm *mvm);
+void iwl_mvm_send_tcm_event(struct iwl_mvm *mvm);
 #endif
 
 static inline u64 iwl_mvm_ptp_get_adj_time(struct iwl_mvm *mvm, u64 base_time)
@@ -2791,6 +3006,14 @@ void iwl_mvm_mac_sta_statistics(struct ieee80211_hw *hw,
 				struct ieee80211_vif *vif,
 				struct ieee80211_sta *sta,
 				struct station_info *sinfo);
+int iwl_mvm_mac_get_et_sset_count(struct ieee80211_hw *hw,
+				  struct ieee80211_vif *vif, int sset);
+void iwl_mvm_mac_get_et_strings(struct ieee80211_hw *hw,
+				struct ieee80211_vif *vif,
+				u32 sset, u8 *data);
+void iwl_mvm_mac_get_et_stats(struct ieee80211_hw *hw,
+			      struct ieee80211_vif *vif,
+			      struct ethtool_stats *stats, u64 *data);
 int
 iwl_mvm_mac_get_ftm_responder_stats(struct ieee80211_hw *hw,
 				    struct ieee80211_vif *vif,
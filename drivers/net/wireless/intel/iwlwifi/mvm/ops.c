@@ -281,39 +281,6 @@ static void iwl_mvm_rx_thermal_dual_chain_req(struct iwl_mvm *mvm,
 				     iwl_mvm_intf_dual_chain_req, NULL);
 }
 
-/**
- * enum iwl_rx_handler_context: context for Rx handler
- * @RX_HANDLER_SYNC : this means that it will be called in the Rx path
- *	which can't acquire mvm->mutex.
- * @RX_HANDLER_ASYNC_LOCKED : If the handler needs to hold mvm->mutex
- *	(and only in this case!), it should be set as ASYNC. In that case,
- *	it will be called from a worker with mvm->mutex held.
- * @RX_HANDLER_ASYNC_UNLOCKED : in case the handler needs to lock the
- *	mutex itself, it will be called from a worker without mvm->mutex held.
- * @RX_HANDLER_ASYNC_LOCKED_WIPHY: If the handler needs to hold the wiphy lock
- *	and mvm->mutex. Will be handled with the wiphy_work queue infra
- *	instead of regular work queue.
- */
-enum iwl_rx_handler_context {
-	RX_HANDLER_SYNC,
-	RX_HANDLER_ASYNC_LOCKED,
-	RX_HANDLER_ASYNC_UNLOCKED,
-	RX_HANDLER_ASYNC_LOCKED_WIPHY,
-};
-
-/**
- * struct iwl_rx_handlers: handler for FW notification
- * @cmd_id: command id
- * @min_size: minimum size to expect for the notification
- * @context: see &iwl_rx_handler_context
- * @fn: the function is called when notification is received
- */
-struct iwl_rx_handlers {
-	u16 cmd_id, min_size;
-	enum iwl_rx_handler_context context;
-	void (*fn)(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
-};
-
 #define RX_HANDLER_NO_SIZE(_cmd_id, _fn, _context)		\
 	{ .cmd_id = _cmd_id, .fn = _fn, .context = _context, }
 #define RX_HANDLER_GRP_NO_SIZE(_grp, _cmd, _fn, _context)	\
@@ -328,11 +295,13 @@ struct iwl_rx_handlers {
 /*
  * Handlers for fw notifications
  * Convention: RX_HANDLER(CMD_NAME, iwl_mvm_rx_CMD_NAME
- * This list should be in order of frequency for performance purposes.
+ * Lookup is done through &struct iwl_mvm_rx_handler_map, so the order
+ * doesn't matter for performance, but IDs should be unique.
  *
  * The handler can be one from three contexts, see &iwl_rx_handler_context
  */
-static const struct iwl_rx_handlers iwl_mvm_rx_handlers[] = {
+VISIBLE_IF_IWLWIFI_KUNIT
+const struct iwl_rx_handlers iwl_mvm_rx_handlers[] = {
 	RX_HANDLER(TX_CMD, iwl_mvm_rx_tx_cmd, RX_HANDLER_SYNC,
 		   struct iwl_mvm_tx_resp),
 	RX_HANDLER(BA_NOTIF, iwl_mvm_rx_ba_notif, RX_HANDLER_SYNC,
@@ -490,9 +459,90 @@ static const struct iwl_rx_handlers iwl_mvm_rx_handlers[] = {
 		       iwl_mvm_rx_roc_notif, RX_HANDLER_SYNC,
 		       struct iwl_roc_notif),
 };
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_rx_handlers);
 #undef RX_HANDLER
 #undef RX_HANDLER_GRP
 
+#if IS_ENABLED(CPTCFG_IWLWIFI_KUNIT_TESTS)
+const unsigned int iwl_mvm_rx_handlers_size = ARRAY_SIZE(iwl_mvm_rx_handlers);
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_rx_handlers_size);
+#endif
+
+/*
+ * The notification handlers are looked up for every notification that
+ * isn't an MPDU, so rather than scanning iwl_mvm_rx_handlers[] each time
+ * build a two-level group/command lookup once. Groups that have no
+ * handlers don't get a table at all.
+ */
+int iwl_mvm_rx_handler_map_init(struct iwl_mvm_rx_handler_map *map,
+				const struct iwl_rx_handlers *handlers,
+				int n_handlers)
+{
+	int i;
+
+	/* the index is stored as u8 with 0 meaning "no handler" */
+	if (WARN_ON(n_handlers >= U8_MAX))
+		return -EINVAL;
+
+	memset(map, 0, sizeof(*map));
+	map->handlers = handlers;
+
+	for (i = 0; i < n_handlers; i++) {
+		u8 grp = iwl_cmd_groupid(handlers[i].cmd_id);
+		u8 cmd = iwl_cmd_opcode(handlers[i].cmd_id);
+
+		if (WARN_ON(grp >= ARRAY_SIZE(map->grp))) {
+			iwl_mvm_rx_handler_map_free(map);
+			return -EINVAL;
+		}
+
+		if (!map->grp[grp]) {
+			map->grp[grp] = kcalloc(U8_MAX + 1, sizeof(u8),
+						GFP_KERNEL);
+			if (!map->grp[grp]) {
+				iwl_mvm_rx_handler_map_free(map);
+				return -ENOMEM;
+			}
+		}
+
+		/* keep the first match, like the linear search did */
+		if (!map->grp[grp][cmd])
+			map->grp[grp][cmd] = i + 1;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_rx_handler_map_init);
+
+void iwl_mvm_rx_handler_map_free(struct iwl_mvm_rx_handler_map *map)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(map->grp); i++) {
+		kfree(map->grp[i]);
+		map->grp[i] = NULL;
+	}
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_rx_handler_map_free);
+
+const struct iwl_rx_handlers *
+iwl_mvm_rx_handler_map_lookup(const struct iwl_mvm_rx_handler_map *map,
+			      u16 cmd_id)
+{
+	u8 grp = iwl_cmd_groupid(cmd_id);
+	u8 idx;
+
+	if (grp >= ARRAY_SIZE(map->grp) || !map->grp[grp])
+		return NULL;
+
+	idx = map->grp[grp][iwl_cmd_opcode(cmd_id)];
+	if (!idx)
+		return NULL;
+
+	return &map->handlers[idx - 1];
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_rx_handler_map_lookup);
+
 /* Please keep this array *SORTED* by hex value.
  * Access is done through binary search
  */
@@ -760,6 +810,8 @@ static const struct iwl_hcmd_arr iwl_mvm_groups[] = {
 static void iwl_mvm_async_handlers_wk(struct work_struct *wk);
 static void iwl_mvm_async_handlers_wiphy_wk(struct wiphy *wiphy,
 					    struct wiphy_work *work);
+static int iwl_mvm_async_handlers_pool_alloc(struct iwl_mvm *mvm);
+static void iwl_mvm_async_handlers_pool_free(struct iwl_mvm *mvm);
 
 static u32 iwl_mvm_min_backoff(struct iwl_mvm *mvm)
 {
@@ -1058,6 +1110,8 @@ out_free:
 	iwl_trans_op_mode_leave(mvm->trans);
 	kfree(mvm->nvm_data);
 	kfree(mvm->mei_nvm_data);
+	iwl_mvm_rx_handler_map_free(&mvm->rx_handler_map);
+	iwl_mvm_async_handlers_pool_free(mvm);
 
 	ieee80211_free_hw(mvm->hw);
 }
@@ -1279,6 +1333,7 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	size_t scan_size;
 	u32 min_backoff;
 	struct iwl_mvm_csme_conn_info *csme_conn_info __maybe_unused;
+	int i;
 
 	/*
 	 * We use IWL_MVM_STATION_COUNT_MAX to check the validity of the station
@@ -1387,6 +1442,12 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	INIT_LIST_HEAD(&mvm->time_event_list);
 	INIT_LIST_HEAD(&mvm->aux_roc_te_list);
 	INIT_LIST_HEAD(&mvm->async_handlers_list);
+	for (i = 0; i < ARRAY_SIZE(mvm->rx_batch); i++)
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+		INIT_LIST_HEAD(&mvm->rx_batch[i]);
+#else
+		__skb_queue_head_init(&mvm->rx_batch[i]);
+#endif
 	spin_lock_init(&mvm->time_event_lock);
 	INIT_LIST_HEAD(&mvm->ftm_initiator.loc_list);
 	INIT_LIST_HEAD(&mvm->ftm_initiator.pasn_list);
@@ -1422,6 +1483,9 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	mvm->tcm.ts = jiffies;
 	mvm->tcm.ll_ts = jiffies;
 	mvm->tcm.uapsd_nonagg_ts = jiffies;
+	mvm->tcm.period = msecs_to_jiffies(IWL_MVM_TCM_PERIOD_MSEC);
+	/* without the MLD API the per-link data is kept per MAC */
+	BUILD_BUG_ON(NUM_MAC_INDEX_DRIVER > IWL_MVM_TCM_NUM_LINKS);
 
 #ifdef CPTCFG_IWLMVM_TDLS_PEER_CACHE
 	INIT_LIST_HEAD(&mvm->tdls_peer_cache_list);
@@ -1432,6 +1496,8 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 #endif
 
 	INIT_DELAYED_WORK(&mvm->cs_tx_unblock_dwork, iwl_mvm_tx_unblock_dwork);
+	INIT_DELAYED_WORK(&mvm->lq_flush.wk, iwl_mvm_rs_lq_flush_wk);
+	mvm->lq_flush.since = jiffies;
 
 #ifdef CPTCFG_IWLMVM_VENDOR_CMDS
 	/* set command/notification versions we care about */
@@ -1449,6 +1515,14 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	if (WARN_ON_ONCE(mvm->cmd_ver.range_resp > 9))
 		goto out_free;
 
+	if (iwl_mvm_rx_handler_map_init(&mvm->rx_handler_map,
+					iwl_mvm_rx_handlers,
+					ARRAY_SIZE(iwl_mvm_rx_handlers)))
+		goto out_free;
+
+	if (iwl_mvm_async_handlers_pool_alloc(mvm))
+		goto out_free;
+
 	/*
 	 * Populate the state variables that the transport layer needs
 	 * to know about.
@@ -1623,6 +1697,8 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	iwl_phy_db_free(mvm->phy_db);
 	kfree(mvm->scan_cmd);
 	iwl_trans_op_mode_leave(trans);
+	iwl_mvm_rx_handler_map_free(&mvm->rx_handler_map);
+	iwl_mvm_async_handlers_pool_free(mvm);
 
 	ieee80211_free_hw(mvm->hw);
 	return NULL;
@@ -1698,6 +1774,8 @@ static void iwl_op_mode_mvm_stop(struct iwl_op_mode *op_mode)
 #endif /* CPTCFG_IWLMVM_VENDOR_CMDS */
 
 	iwl_trans_op_mode_leave(mvm->trans);
+	iwl_mvm_rx_handler_map_free(&mvm->rx_handler_map);
+	iwl_mvm_async_handlers_pool_free(mvm);
 
 	iwl_phy_db_free(mvm->phy_db);
 	mvm->phy_db = NULL;
@@ -1741,8 +1819,130 @@ struct iwl_async_handler_entry {
 	struct iwl_rx_cmd_buffer rxb;
 	enum iwl_rx_handler_context context;
 	void (*fn)(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
+	bool pooled;
 };
 
+static void iwl_mvm_async_handlers_pool_free(struct iwl_mvm *mvm)
+{
+	struct iwl_async_handler_entry *entry, *tmp;
+
+	list_for_each_entry_safe(entry, tmp, &mvm->async_handlers_reserve,
+				 list)
+		kfree(entry);
+	INIT_LIST_HEAD(&mvm->async_handlers_reserve);
+	mvm->async_handlers_reserve_len = 0;
+
+	kfree(mvm->async_handlers_pool);
+	mvm->async_handlers_pool = NULL;
+	INIT_LIST_HEAD(&mvm->async_handlers_free);
+}
+
+static int iwl_mvm_async_handlers_pool_alloc(struct iwl_mvm *mvm)
+{
+	int i;
+
+	INIT_LIST_HEAD(&mvm->async_handlers_free);
+	INIT_LIST_HEAD(&mvm->async_handlers_reserve);
+	mvm->async_handlers_reserve_len = 0;
+
+	mvm->async_handlers_pool =
+		kcalloc(IWL_MVM_ASYNC_HANDLERS_POOL_SIZE,
+			sizeof(*mvm->async_handlers_pool), GFP_KERNEL);
+	if (!mvm->async_handlers_pool)
+		return -ENOMEM;
+
+	for (i = 0; i < IWL_MVM_ASYNC_HANDLERS_POOL_SIZE; i++) {
+		struct iwl_async_handler_entry *entry =
+			&mvm->async_handlers_pool[i];
+
+		entry->pooled = true;
+		list_add_tail(&entry->list, &mvm->async_handlers_free);
+	}
+
+	for (i = 0; i < IWL_MVM_ASYNC_HANDLERS_RESERVE; i++) {
+		struct iwl_async_handler_entry *entry;
+
+		entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+		if (!entry) {
+			iwl_mvm_async_handlers_pool_free(mvm);
+			return -ENOMEM;
+		}
+
+		list_add_tail(&entry->list, &mvm->async_handlers_reserve);
+		mvm->async_handlers_reserve_len++;
+	}
+
+	return 0;
+}
+
+/*
+ * Take an entry from the pool, or from the reserve if the pool was
+ * exhausted. Only if both are empty, i.e. the workers haven't run for a
+ * long time, try to allocate one. Must be called with async_handlers_lock
+ * held.
+ */
+static struct iwl_async_handler_entry *
+iwl_mvm_async_handler_entry_get(struct iwl_mvm *mvm)
+{
+	struct iwl_mvm_async_handlers_stats *stats =
+		&mvm->async_handlers_stats;
+	struct iwl_async_handler_entry *entry;
+
+	lockdep_assert_held(&mvm->async_handlers_lock);
+
+	entry = list_first_entry_or_null(&mvm->async_handlers_free,
+					 struct iwl_async_handler_entry, list);
+	if (!entry) {
+		entry = list_first_entry_or_null(&mvm->async_handlers_reserve,
+						 struct iwl_async_handler_entry,
+						 list);
+		if (entry) {
+			mvm->async_handlers_reserve_len--;
+			stats->reserve_used++;
+		}
+	}
+
+	if (entry) {
+		list_del(&entry->list);
+	} else {
+		entry = kzalloc(sizeof(*entry), GFP_ATOMIC);
+		if (!entry) {
+			stats->drops++;
+			return NULL;
+		}
+		stats->fallbacks++;
+	}
+
+	stats->in_use++;
+	if (stats->in_use > stats->hwm)
+		stats->hwm = stats->in_use;
+
+	return entry;
+}
+
+/*
+ * Must be called with async_handlers_lock held, entry must be unlinked.
+ * Entries not from the pool refill the reserve first, so the workers top
+ * it up again as they catch up.
+ */
+static void iwl_mvm_async_handler_entry_put(struct iwl_mvm *mvm,
+					    struct iwl_async_handler_entry *entry)
+{
+	lockdep_assert_held(&mvm->async_handlers_lock);
+
+	mvm->async_handlers_stats.in_use--;
+
+	if (entry->pooled) {
+		list_add(&entry->list, &mvm->async_handlers_free);
+	} else if (mvm->async_handlers_reserve_len <
+		   IWL_MVM_ASYNC_HANDLERS_RESERVE) {
+		list_add(&entry->list, &mvm->async_handlers_reserve);
+		mvm->async_handlers_reserve_len++;
+	} else {
+		kfree(entry);
+	}
+}
+
 void iwl_mvm_async_handlers_purge(struct iwl_mvm *mvm)
 {
 	struct iwl_async_handler_entry *entry, *tmp;
@@ -1751,7 +1951,7 @@ void iwl_mvm_async_handlers_purge(struct iwl_mvm *mvm)
 	list_for_each_entry_safe(entry, tmp, &mvm->async_handlers_list, list) {
 		iwl_free_rxb(&entry->rxb);
 		list_del(&entry->list);
-		kfree(entry);
+		iwl_mvm_async_handler_entry_put(mvm, entry);
 	}
 	spin_unlock_bh(&mvm->async_handlers_lock);
 }
@@ -1780,16 +1980,25 @@ static void iwl_mvm_async_handlers_by_context(struct iwl_mvm *mvm,
 	}
 	spin_unlock_bh(&mvm->async_handlers_lock);
 
-	list_for_each_entry_safe(entry, tmp, &local_list, list) {
+	list_for_each_entry(entry, &local_list, list) {
 		if (entry->context != RX_HANDLER_ASYNC_UNLOCKED)
 			mutex_lock(&mvm->mutex);
 		entry->fn(mvm, &entry->rxb);
 		iwl_free_rxb(&entry->rxb);
-		list_del(&entry->list);
 		if (entry->context != RX_HANDLER_ASYNC_UNLOCKED)
 			mutex_unlock(&mvm->mutex);
-		kfree(entry);
 	}
+
+	if (list_empty(&local_list))
+		return;
+
+	/* return all the handled entries at once */
+	spin_lock_bh(&mvm->async_handlers_lock);
+	list_for_each_entry_safe(entry, tmp, &local_list, list) {
+		list_del(&entry->list);
+		iwl_mvm_async_handler_entry_put(mvm, entry);
+	}
+	spin_unlock_bh(&mvm->async_handlers_lock);
 }
 
 static void iwl_mvm_async_handlers_wiphy_wk(struct wiphy *wiphy,
@@ -1847,7 +2056,8 @@ static void iwl_mvm_rx_common(struct iwl_mvm *mvm,
 			      struct iwl_rx_packet *pkt)
 {
 	unsigned int pkt_len = iwl_rx_packet_payload_len(pkt);
-	int i;
+	const struct iwl_rx_handlers *rx_h;
+	struct iwl_async_handler_entry *entry;
 	union iwl_dbg_tlv_tp_data tp_data = { .fw_pkt = pkt };
 
 	iwl_dbg_tlv_time_point(&mvm->fwrt,
@@ -1861,43 +2071,42 @@ static void iwl_mvm_rx_common(struct iwl_mvm *mvm,
 	 */
 	iwl_notification_wait_notify(&mvm->notif_wait, pkt);
 
-	for (i = 0; i < ARRAY_SIZE(iwl_mvm_rx_handlers); i++) {
-		const struct iwl_rx_handlers *rx_h = &iwl_mvm_rx_handlers[i];
-		struct iwl_async_handler_entry *entry;
-
-		if (rx_h->cmd_id != WIDE_ID(pkt->hdr.group_id, pkt->hdr.cmd))
-			continue;
-
-		if (IWL_FW_CHECK(mvm, pkt_len < rx_h->min_size,
-				 "unexpected notification 0x%04x size %d, need %d\n",
-				 rx_h->cmd_id, pkt_len, rx_h->min_size))
-			return;
+	rx_h = iwl_mvm_rx_handler_map_lookup(&mvm->rx_handler_map,
+					     WIDE_ID(pkt->hdr.group_id,
+						     pkt->hdr.cmd));
+	if (!rx_h)
+		return;
 
-		if (rx_h->context == RX_HANDLER_SYNC) {
-			rx_h->fn(mvm, rxb);
-			return;
-		}
+	if (IWL_FW_CHECK(mvm, pkt_len < rx_h->min_size,
+			 "unexpected notification 0x%04x size %d, need %d\n",
+			 rx_h->cmd_id, pkt_len, rx_h->min_size))
+		return;
 
-		entry = kzalloc(sizeof(*entry), GFP_ATOMIC);
-		/* we can't do much... */
-		if (!entry)
-			return;
+	if (rx_h->context == RX_HANDLER_SYNC) {
+		rx_h->fn(mvm, rxb);
+		return;
+	}
 
-		entry->rxb._page = rxb_steal_page(rxb);
-		entry->rxb._offset = rxb->_offset;
-		entry->rxb._rx_page_order = rxb->_rx_page_order;
-		entry->fn = rx_h->fn;
-		entry->context = rx_h->context;
-		spin_lock(&mvm->async_handlers_lock);
-		list_add_tail(&entry->list, &mvm->async_handlers_list);
+	spin_lock(&mvm->async_handlers_lock);
+	entry = iwl_mvm_async_handler_entry_get(mvm);
+	/* pool and reserve exhausted and the fallback failed, counted */
+	if (!entry) {
 		spin_unlock(&mvm->async_handlers_lock);
-		if (rx_h->context == RX_HANDLER_ASYNC_LOCKED_WIPHY)
-			wiphy_work_queue(mvm->hw->wiphy,
-					 &mvm->async_handlers_wiphy_wk);
-		else
-			schedule_work(&mvm->async_handlers_wk);
-		break;
+		return;
 	}
+
+	entry->rxb._page = rxb_steal_page(rxb);
+	entry->rxb._offset = rxb->_offset;
+	entry->rxb._rx_page_order = rxb->_rx_page_order;
+	entry->fn = rx_h->fn;
+	entry->context = rx_h->context;
+	list_add_tail(&entry->list, &mvm->async_handlers_list);
+	spin_unlock(&mvm->async_handlers_lock);
+	if (rx_h->context == RX_HANDLER_ASYNC_LOCKED_WIPHY)
+		wiphy_work_queue(mvm->hw->wiphy,
+				 &mvm->async_handlers_wiphy_wk);
+	else
+		schedule_work(&mvm->async_handlers_wk);
 }
 
 static void iwl_mvm_rx(struct iwl_op_mode *op_mode,
@@ -2189,6 +2398,7 @@ void iwl_mvm_nic_restart(struct iwl_mvm *mvm, bool fw_error)
 		 * collecting debug data.
 		 */
 		set_bit(IWL_MVM_STATUS_HW_RESTART_REQUESTED, &mvm->status);
+		iwl_trans_start_timing_begin(mvm->trans, true);
 
 		if (mvm->fw->ucode_capa.error_log_size) {
 			u32 src_size = mvm->fw->ucode_capa.error_log_size;
@@ -2318,9 +2528,22 @@ static void iwl_mvm_rx_mq_rss(struct iwl_op_mode *op_mode,
 		iwl_mvm_rx_mpdu_mq(mvm, napi, rxb, queue);
 }
 
+static void iwl_mvm_rx_mq_done(struct iwl_op_mode *op_mode,
+			       struct napi_struct *napi,
+			       unsigned int queue)
+{
+	struct iwl_mvm *mvm = IWL_OP_MODE_GET_MVM(op_mode);
+
+	if (unlikely(queue >= mvm->trans->num_rx_queues))
+		return;
+
+	iwl_mvm_rx_batch_flush(mvm, napi, queue);
+}
+
 static const struct iwl_op_mode_ops iwl_mvm_ops_mq = {
 	IWL_MVM_COMMON_OPS,
 	IWL_MVM_COMMON_TEST_OPS
 	.rx = iwl_mvm_rx_mq,
 	.rx_rss = iwl_mvm_rx_mq_rss,
+	.rx_done = iwl_mvm_rx_mq_done,
 };
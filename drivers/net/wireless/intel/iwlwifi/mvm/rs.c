@@ -1529,6 +1529,59 @@ static void rs_set_amsdu_len(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 	}
 }
 
+/*
+ * Rate scaling may change the rate table on every TX status, so don't
+ * send the LQ command right away. Mark the station instead and send the
+ * latest table of all the marked stations a little later, so that the
+ * changes in between are coalesced into a single command.
+ */
+static void rs_send_lq_cmd_deferred(struct iwl_mvm *mvm,
+				    struct iwl_lq_sta *lq_sta)
+{
+	unsigned long delay = msecs_to_jiffies(IWL_MVM_RS_LQ_COALESCE_MSEC);
+	u8 sta_id = lq_sta->lq.sta_id;
+
+	atomic_inc(&mvm->lq_flush.requested);
+
+	if (WARN_ON_ONCE(sta_id >= ARRAY_SIZE(mvm->fw_id_to_mac_id)))
+		return;
+
+	if (!test_and_set_bit(sta_id, mvm->lq_flush.dirty))
+		schedule_delayed_work(&mvm->lq_flush.wk, delay);
+}
+
+void iwl_mvm_rs_lq_flush_wk(struct work_struct *wk)
+{
+	struct iwl_mvm *mvm = container_of(wk, struct iwl_mvm,
+					   lq_flush.wk.work);
+	int sta_id;
+
+	rcu_read_lock();
+	for_each_set_bit(sta_id, mvm->lq_flush.dirty,
+			 ARRAY_SIZE(mvm->fw_id_to_mac_id)) {
+		struct ieee80211_sta *sta;
+		struct iwl_lq_sta *lq_sta;
+
+		if (!test_and_clear_bit(sta_id, mvm->lq_flush.dirty))
+			continue;
+
+		sta = rcu_dereference(mvm->fw_id_to_mac_id[sta_id]);
+		if (IS_ERR_OR_NULL(sta))
+			continue;
+
+		lq_sta = &iwl_mvm_sta_from_mac80211(sta)->deflink.lq_sta.rs_drv;
+
+		spin_lock_bh(&lq_sta->pers.lock);
+		/* the station ID may have been reused in the meantime */
+		if (lq_sta->lq.sta_id == sta_id) {
+			iwl_mvm_send_lq_cmd(mvm, &lq_sta->lq);
+			mvm->lq_flush.sent++;
+		}
+		spin_unlock_bh(&lq_sta->pers.lock);
+	}
+	rcu_read_unlock();
+}
+
 /*
  * setup rate table in uCode
  */
@@ -1538,7 +1591,7 @@ static void rs_update_rate_tbl(struct iwl_mvm *mvm,
 			       struct iwl_scale_tbl_info *tbl)
 {
 	rs_fill_lq_cmd(mvm, sta, lq_sta, &tbl->rate);
-	iwl_mvm_send_lq_cmd(mvm, &lq_sta->lq);
+	rs_send_lq_cmd_deferred(mvm, lq_sta);
 }
 
 static bool rs_tweak_rate_tbl(struct iwl_mvm *mvm,
@@ -3135,7 +3188,7 @@ static void __iwl_mvm_rs_tx_status(struct iwl_mvm *mvm,
 			IWL_DEBUG_RATE(mvm,
 				       "Too many rates mismatch. Send sync LQ. rs_state %d\n",
 				       lq_sta->rs_state);
-			iwl_mvm_send_lq_cmd(mvm, &lq_sta->lq);
+			rs_send_lq_cmd_deferred(mvm, lq_sta);
 		}
 		/* Regardless, ignore this status info for outdated rate */
 		return;
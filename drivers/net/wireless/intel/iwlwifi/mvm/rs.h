@@ -401,6 +401,8 @@ void iwl_mvm_rs_rate_init(struct iwl_mvm *mvm,
 void iwl_mvm_rs_tx_status(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 			  int tid, struct ieee80211_tx_info *info, bool ndp);
 
+void iwl_mvm_rs_lq_flush_wk(struct work_struct *wk);
+
 /**
  * iwl_rate_control_register - Register the rate control algorithm callbacks
  *
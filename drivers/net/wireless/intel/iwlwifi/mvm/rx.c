@@ -203,6 +203,7 @@ static void iwl_mvm_rx_handle_tcm(struct iwl_mvm *mvm,
 				  u32 rate_n_flags)
 {
 	struct iwl_mvm_sta *mvmsta;
+	struct iwl_mvm_tcm_link *ldata;
 	struct iwl_mvm_tcm_mac *mdata;
 	struct iwl_mvm_vif *mvmvif;
 	int mac;
@@ -223,15 +224,20 @@ static void iwl_mvm_rx_handle_tcm(struct iwl_mvm *mvm,
 	mvmsta = iwl_mvm_sta_from_mac80211(sta);
 	mac = mvmsta->mac_id_n_color & FW_CTXT_ID_MSK;
 
-	if (time_after(jiffies, mvm->tcm.ts + MVM_TCM_PERIOD))
+	if (time_after(jiffies, mvm->tcm.ts + mvm->tcm.period))
 		schedule_delayed_work(&mvm->tcm.work, 0);
 	mdata = &mvm->tcm.data[mac];
 	mdata->rx.pkts[ac]++;
 
+	/* this is only used without the MLD API, so the link is the MAC */
+	ldata = &mvm->tcm.link[mac];
+	ldata->pkts[ac]++;
+
 	/* count the airtime only once for each ampdu */
 	if (mdata->rx.last_ampdu_ref != mvm->ampdu_ref) {
 		mdata->rx.last_ampdu_ref = mvm->ampdu_ref;
 		mdata->rx.airtime += le16_to_cpu(phy_info->frame_time);
+		ldata->airtime[ac] += le16_to_cpu(phy_info->frame_time);
 	}
 	mvmvif = iwl_mvm_vif_from_mac80211(mvmsta->vif);
 
@@ -748,6 +754,13 @@ iwl_mvm_update_tcm_from_stats(struct iwl_mvm *mvm, __le32 *air_time_le,
 
 		mdata->rx.airtime += airtime;
 		mdata->uapsd_nonagg_detect.rx_bytes += rx_bytes;
+		/*
+		 * Firmware statistics aren't split per AC, account them as
+		 * best effort. With the MLD API the per-link statistics are
+		 * accounted separately.
+		 */
+		if (!iwl_mvm_has_mld_api(mvm->fw))
+			mvm->tcm.link[i].airtime[IEEE80211_AC_BE] += airtime;
 		if (airtime) {
 			/* re-init every time to store rate from FW */
 			ewma_rate_init(&mdata->uapsd_nonagg_detect.rate);
@@ -758,6 +771,26 @@ iwl_mvm_update_tcm_from_stats(struct iwl_mvm *mvm, __le32 *air_time_le,
 	spin_unlock(&mvm->tcm.lock);
 }
 
+static void
+iwl_mvm_update_tcm_links_from_stats(struct iwl_mvm *mvm,
+				    struct iwl_stats_ntfy_per_link *per_link)
+{
+	int i;
+
+	BUILD_BUG_ON(IWL_STATS_MAX_FW_LINKS != ARRAY_SIZE(mvm->tcm.link));
+
+	/* without the MLD API the links are accounted per MAC */
+	if (!iwl_mvm_has_mld_api(mvm->fw))
+		return;
+
+	spin_lock(&mvm->tcm.lock);
+	/* the statistics aren't split per AC, account them as best effort */
+	for (i = 0; i < ARRAY_SIZE(mvm->tcm.link); i++)
+		mvm->tcm.link[i].airtime[IEEE80211_AC_BE] +=
+			le32_to_cpu(per_link[i].air_time);
+	spin_unlock(&mvm->tcm.lock);
+}
+
 static void
 iwl_mvm_stats_ver_15(struct iwl_mvm *mvm,
 		     struct iwl_statistics_operational_ntfy *stats)
@@ -919,6 +952,7 @@ iwl_mvm_stat_iterator_all_links(struct iwl_mvm *mvm,
 		}
 
 		iwl_mvm_update_tcm_from_stats(mvm, air_time_le, rx_bytes_le);
+		iwl_mvm_update_tcm_links_from_stats(mvm, per_link);
 	}
 }
 
@@ -232,7 +232,13 @@ static void iwl_mvm_add_rtap_sniffer_config(struct iwl_mvm *mvm,
 	rx_status->flag |= RX_FLAG_RADIOTAP_TLV_AT_END;
 }
 
-/* iwl_mvm_pass_packet_to_mac80211 - passes the packet for mac80211 */
+/*
+ * iwl_mvm_pass_packet_to_mac80211 - passes the packet for mac80211
+ *
+ * All callers run in the NAPI poll of the given queue with the RCU read
+ * lock held, the frames mac80211 produces are queued on the queue's batch
+ * list and handed to GRO by iwl_mvm_rx_batch_flush() at the end of the poll.
+ */
 static void iwl_mvm_pass_packet_to_mac80211(struct iwl_mvm *mvm,
 					    struct napi_struct *napi,
 					    struct sk_buff *skb, int queue,
@@ -251,7 +257,24 @@ static void iwl_mvm_pass_packet_to_mac80211(struct iwl_mvm *mvm,
 		rx_status->link_id = link_sta->link_id;
 	}
 
-	ieee80211_rx_napi(mvm->hw, sta, skb, napi);
+	ieee80211_rx_list(mvm->hw, sta, skb, &mvm->rx_batch[queue]);
+}
+
+void iwl_mvm_rx_batch_flush(struct iwl_mvm *mvm, struct napi_struct *napi,
+			    int queue)
+{
+	struct sk_buff *skb;
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+	struct sk_buff *tmp;
+
+	list_for_each_entry_safe(skb, tmp, &mvm->rx_batch[queue], list) {
+		skb_list_del_init(skb);
+		napi_gro_receive(napi, skb);
+	}
+#else
+	while ((skb = __skb_dequeue(&mvm->rx_batch[queue])))
+		napi_gro_receive(napi, skb);
+#endif
 }
 
 static void iwl_mvm_get_signal_strength(struct iwl_mvm *mvm,
@@ -557,40 +580,91 @@ static bool iwl_mvm_is_dup(struct ieee80211_sta *sta, int queue,
 	return false;
 }
 
+/*
+ * iwl_mvm_reorder_buf_store - store a frame in the reorder buffer
+ */
+VISIBLE_IF_IWLWIFI_KUNIT void
+iwl_mvm_reorder_buf_store(struct iwl_mvm_reorder_buffer *buf, u16 sn,
+			  struct sk_buff *skb)
+{
+	int index = sn % buf->buf_size;
+
+	/* more than one frame per slot for A-MSDU */
+	__skb_queue_tail(&buf->entries[index], skb);
+	__set_bit(index, buf->stored);
+	buf->num_stored++;
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_reorder_buf_store);
+
+static void iwl_mvm_reorder_buf_splice(struct iwl_mvm_reorder_buffer *buf,
+				       unsigned long from, unsigned long to,
+				       struct sk_buff_head *frames)
+{
+	unsigned long index = from;
+
+	for_each_set_bit_from(index, buf->stored, to) {
+		buf->num_stored -= skb_queue_len(&buf->entries[index]);
+		skb_queue_splice_tail_init(&buf->entries[index], frames);
+		__clear_bit(index, buf->stored);
+
+		if (!buf->num_stored)
+			break;
+	}
+}
+
+/*
+ * iwl_mvm_reorder_buf_release - move the head of the reorder buffer to nssn
+ *
+ * Moves all the frames stored before nssn to @frames, in order.
+ */
+VISIBLE_IF_IWLWIFI_KUNIT void
+iwl_mvm_reorder_buf_release(struct iwl_mvm_reorder_buffer *buf, u16 nssn,
+			    struct sk_buff_head *frames)
+{
+	u16 sn = buf->head_sn;
+	u16 count = 0;
+
+	if (ieee80211_sn_less(buf->head_sn, nssn))
+		count = min_t(u16, ieee80211_sn_sub(nssn, buf->head_sn),
+			      buf->buf_size);
+
+	/*
+	 * Walk the SNs in runs that map to consecutive slots. A run ends at
+	 * the end of the slots and, since buf_size needn't divide the SN
+	 * space, also where the SN wraps around.
+	 */
+	while (buf->num_stored && count) {
+		u16 index = sn % buf->buf_size;
+		u16 len = min3(count, (u16)(buf->buf_size - index),
+			       (u16)(IEEE80211_SN_MODULO - sn));
+
+		iwl_mvm_reorder_buf_splice(buf, index, index + len, frames);
+		sn = ieee80211_sn_add(sn, len);
+		count -= len;
+	}
+
+	buf->head_sn = nssn;
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_reorder_buf_release);
+
 static void iwl_mvm_release_frames(struct iwl_mvm *mvm,
 				   struct ieee80211_sta *sta,
 				   struct napi_struct *napi,
-				   struct iwl_mvm_baid_data *baid_data,
 				   struct iwl_mvm_reorder_buffer *reorder_buf,
 				   u16 nssn)
 {
-	struct iwl_mvm_reorder_buf_entry *entries =
-		&baid_data->entries[reorder_buf->queue *
-				    baid_data->entries_per_queue];
-	u16 ssn = reorder_buf->head_sn;
+	struct sk_buff_head frames;
+	struct sk_buff *skb;
 
 	lockdep_assert_held(&reorder_buf->lock);
 
-	while (ieee80211_sn_less(ssn, nssn)) {
-		int index = ssn % reorder_buf->buf_size;
-		struct sk_buff_head *skb_list = &entries[index].frames;
-		struct sk_buff *skb;
+	__skb_queue_head_init(&frames);
+	iwl_mvm_reorder_buf_release(reorder_buf, nssn, &frames);
 
-		ssn = ieee80211_sn_inc(ssn);
-
-		/*
-		 * Empty the list. Will have more than one frame for A-MSDU.
-		 * Empty list is valid as well since nssn indicates frames were
-		 * received.
-		 */
-		while ((skb = __skb_dequeue(skb_list))) {
-			iwl_mvm_pass_packet_to_mac80211(mvm, napi, skb,
-							reorder_buf->queue,
-							sta, NULL /* FIXME */);
-			reorder_buf->num_stored--;
-		}
-	}
-	reorder_buf->head_sn = nssn;
+	while ((skb = __skb_dequeue(&frames)))
+		iwl_mvm_pass_packet_to_mac80211(mvm, napi, skb,
+						reorder_buf->queue,
+						sta, NULL /* FIXME */);
 }
 
 static void iwl_mvm_del_ba(struct iwl_mvm *mvm, int queue,
@@ -621,7 +695,7 @@ static void iwl_mvm_del_ba(struct iwl_mvm *mvm, int queue,
 
 	/* release all frames that are in the reorder buffer to the stack */
 	spin_lock_bh(&reorder_buf->lock);
-	iwl_mvm_release_frames(mvm, sta, NULL, ba_data, reorder_buf,
+	iwl_mvm_release_frames(mvm, sta, NULL, reorder_buf,
 			       ieee80211_sn_add(reorder_buf->head_sn,
 						reorder_buf->buf_size));
 	spin_unlock_bh(&reorder_buf->lock);
@@ -663,8 +737,7 @@ static void iwl_mvm_release_frames_from_notif(struct iwl_mvm *mvm,
 	reorder_buf = &ba_data->reorder_buf[queue];
 
 	spin_lock_bh(&reorder_buf->lock);
-	iwl_mvm_release_frames(mvm, sta, napi, ba_data,
-			       reorder_buf, nssn);
+	iwl_mvm_release_frames(mvm, sta, napi, reorder_buf, nssn);
 	spin_unlock_bh(&reorder_buf->lock);
 
 out:
@@ -739,9 +812,7 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	u8 tid = ieee80211_get_tid(hdr);
 	u8 sub_frame_idx = desc->amsdu_info &
 			   IWL_RX_MPDU_AMSDU_SUBFRAME_IDX_MASK;
-	struct iwl_mvm_reorder_buf_entry *entries;
 	u32 sta_mask;
-	int index;
 	u16 nssn, sn;
 	u8 baid;
 
@@ -800,7 +871,6 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 		IWL_RX_MPDU_REORDER_SN_SHIFT;
 
 	buffer = &baid_data->reorder_buf[queue];
-	entries = &baid_data->entries[queue * baid_data->entries_per_queue];
 
 	spin_lock_bh(&buffer->lock);
 
@@ -847,9 +917,7 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	}
 
 	/* put in reorder buffer */
-	index = sn % buffer->buf_size;
-	__skb_queue_tail(&entries[index].frames, skb);
-	buffer->num_stored++;
+	iwl_mvm_reorder_buf_store(buffer, sn, skb);
 
 	if (amsdu) {
 		buffer->last_amsdu = sn;
@@ -868,8 +936,7 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	 * release notification with up to date NSSN.
 	 */
 	if (!amsdu || last_subframe)
-		iwl_mvm_release_frames(mvm, sta, napi, baid_data,
-				       buffer, nssn);
+		iwl_mvm_release_frames(mvm, sta, napi, buffer, nssn);
 
 	spin_unlock_bh(&buffer->lock);
 	return true;
@@ -2249,7 +2316,7 @@ void iwl_mvm_rx_mpdu_mq(struct iwl_mvm *mvm, struct napi_struct *napi,
 		if (!mvm->tcm.paused && len >= sizeof(*hdr) &&
 		    !is_multicast_ether_addr(hdr->addr1) &&
 		    ieee80211_is_data(hdr->frame_control) &&
-		    time_after(jiffies, mvm->tcm.ts + MVM_TCM_PERIOD))
+		    time_after(jiffies, mvm->tcm.ts + mvm->tcm.period))
 			schedule_delayed_work(&mvm->tcm.work, 0);
 
 		/*
@@ -2503,7 +2570,7 @@ void iwl_mvm_rx_monitor_no_data(struct iwl_mvm *mvm, struct napi_struct *napi,
 	}
 
 	rcu_read_lock();
-	ieee80211_rx_napi(mvm->hw, sta, skb, napi);
+	ieee80211_rx_list(mvm->hw, sta, skb, &mvm->rx_batch[queue]);
 	rcu_read_unlock();
 }
 
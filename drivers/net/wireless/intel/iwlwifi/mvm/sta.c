@@ -984,10 +984,12 @@ static bool iwl_mvm_update_txq_mapping(struct iwl_mvm *mvm,
 	return enable_queue;
 }
 
-static bool iwl_mvm_enable_txq(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
-			       int queue, u16 ssn,
-			       const struct iwl_trans_txq_scd_cfg *cfg,
-			       unsigned int wdg_timeout)
+static bool __iwl_mvm_enable_txq(struct iwl_mvm *mvm,
+				 struct ieee80211_sta *sta,
+				 int queue, u16 ssn,
+				 const struct iwl_trans_txq_scd_cfg *cfg,
+				 unsigned int wdg_timeout,
+				 struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_scd_txq_cfg_cmd cmd = {
 		.scd_queue = queue,
@@ -1000,6 +1002,7 @@ static bool iwl_mvm_enable_txq(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 		.tid = cfg->tid,
 	};
 	bool inc_ssn;
+	int ret;
 
 	if (WARN_ON(iwl_mvm_has_new_tx_api(mvm)))
 		return false;
@@ -1013,12 +1016,27 @@ static bool iwl_mvm_enable_txq(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 	if (inc_ssn)
 		le16_add_cpu(&cmd.ssn, 1);
 
-	WARN(iwl_mvm_send_cmd_pdu(mvm, SCD_QUEUE_CFG, 0, sizeof(cmd), &cmd),
-	     "Failed to configure queue %d on FIFO %d\n", queue, cfg->fifo);
+	if (batch)
+		ret = iwl_mvm_cmd_batch_add_pdu(batch, SCD_QUEUE_CFG, 0,
+						sizeof(cmd), &cmd, NULL, NULL);
+	else
+		ret = iwl_mvm_send_cmd_pdu(mvm, SCD_QUEUE_CFG, 0,
+					   sizeof(cmd), &cmd);
+	WARN(ret, "Failed to configure queue %d on FIFO %d\n",
+	     queue, cfg->fifo);
 
 	return inc_ssn;
 }
 
+static bool iwl_mvm_enable_txq(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
+			       int queue, u16 ssn,
+			       const struct iwl_trans_txq_scd_cfg *cfg,
+			       unsigned int wdg_timeout)
+{
+	return __iwl_mvm_enable_txq(mvm, sta, queue, ssn, cfg, wdg_timeout,
+				    NULL);
+}
+
 static void iwl_mvm_change_queue_tid(struct iwl_mvm *mvm, int queue)
 {
 	struct iwl_scd_txq_cfg_cmd cmd = {
@@ -1602,9 +1620,13 @@ static int iwl_mvm_reserve_sta_stream(struct iwl_mvm *mvm,
  * does the re-mapping and queue allocation.
  *
  * Note that re-enabling aggregations isn't done in this function.
+ *
+ * If @batch is given, the queue configuration commands that don't need
+ * a response are queued to it.
  */
 void iwl_mvm_realloc_queues_after_restart(struct iwl_mvm *mvm,
-					  struct ieee80211_sta *sta)
+					  struct ieee80211_sta *sta,
+					  struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_mvm_sta *mvm_sta = iwl_mvm_sta_from_mac80211(sta);
 	unsigned int wdg =
@@ -1667,16 +1689,42 @@ void iwl_mvm_realloc_queues_after_restart(struct iwl_mvm *mvm,
 					    mvm_sta->deflink.sta_id, i,
 					    txq_id);
 
-			iwl_mvm_enable_txq(mvm, sta, txq_id, seq, &cfg, wdg);
+			__iwl_mvm_enable_txq(mvm, sta, txq_id, seq, &cfg, wdg,
+					     batch);
 			mvm->queue_info[txq_id].status = IWL_MVM_QUEUE_READY;
 		}
 	}
 }
 
-static int iwl_mvm_add_int_sta_common(struct iwl_mvm *mvm,
-				      struct iwl_mvm_int_sta *sta,
-				      const u8 *addr,
-				      u16 mac_id, u16 color)
+static int iwl_mvm_add_int_sta_status(struct iwl_mvm *mvm, u32 status)
+{
+	switch (status & IWL_ADD_STA_STATUS_MASK) {
+	case ADD_STA_SUCCESS:
+		IWL_DEBUG_INFO(mvm, "Internal station added.\n");
+		return 0;
+	default:
+		IWL_ERR(mvm, "Add internal station failed, status=0x%x\n",
+			status);
+		return -EIO;
+	}
+}
+
+static int iwl_mvm_add_int_sta_resp(struct iwl_mvm *mvm,
+				    struct iwl_rx_packet *pkt, void *data)
+{
+	struct iwl_cmd_response *resp = (void *)pkt->data;
+
+	if (WARN_ON_ONCE(iwl_rx_packet_payload_len(pkt) != sizeof(*resp)))
+		return -EIO;
+
+	return iwl_mvm_add_int_sta_status(mvm, le32_to_cpu(resp->status));
+}
+
+static int __iwl_mvm_add_int_sta_common(struct iwl_mvm *mvm,
+					struct iwl_mvm_int_sta *sta,
+					const u8 *addr,
+					u16 mac_id, u16 color,
+					struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_mvm_add_sta_cmd cmd;
 	int ret;
@@ -1704,23 +1752,28 @@ static int iwl_mvm_add_int_sta_common(struct iwl_mvm *mvm,
 	if (addr)
 		memcpy(cmd.addr, addr, ETH_ALEN);
 
+	if (batch)
+		return iwl_mvm_cmd_batch_add_pdu(batch, ADD_STA, 0,
+						 iwl_mvm_add_sta_cmd_size(mvm),
+						 &cmd, iwl_mvm_add_int_sta_resp,
+						 NULL);
+
 	ret = iwl_mvm_send_cmd_pdu_status(mvm, ADD_STA,
 					  iwl_mvm_add_sta_cmd_size(mvm),
 					  &cmd, &status);
 	if (ret)
 		return ret;
 
-	switch (status & IWL_ADD_STA_STATUS_MASK) {
-	case ADD_STA_SUCCESS:
-		IWL_DEBUG_INFO(mvm, "Internal station added.\n");
-		return 0;
-	default:
-		ret = -EIO;
-		IWL_ERR(mvm, "Add internal station failed, status=0x%x\n",
-			status);
-		break;
-	}
-	return ret;
+	return iwl_mvm_add_int_sta_status(mvm, status);
+}
+
+static int iwl_mvm_add_int_sta_common(struct iwl_mvm *mvm,
+				      struct iwl_mvm_int_sta *sta,
+				      const u8 *addr,
+				      u16 mac_id, u16 color)
+{
+	return __iwl_mvm_add_int_sta_common(mvm, sta, addr, mac_id, color,
+					    NULL);
 }
 
 /* Initialize driver data of a new sta */
@@ -1845,21 +1898,30 @@ int iwl_mvm_add_sta(struct iwl_mvm *mvm,
 
 	/* if this is a HW restart re-alloc existing queues */
 	if (test_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status)) {
+		static const u16 resp_cmds[] = { ADD_STA };
 		struct iwl_mvm_int_sta tmp_sta = {
 			.sta_id = sta_id,
 			.type = mvm_sta->sta_type,
 		};
+		struct iwl_mvm_cmd_batch batch;
 
 		/*
 		 * First add an empty station since allocating
-		 * a queue requires a valid station
+		 * a queue requires a valid station. The firmware
+		 * handles the commands in order, so the queues can
+		 * be configured without waiting for it.
 		 */
-		ret = iwl_mvm_add_int_sta_common(mvm, &tmp_sta, sta->addr,
-						 mvmvif->id, mvmvif->color);
+		iwl_mvm_cmd_batch_init(mvm, &batch, resp_cmds,
+				       ARRAY_SIZE(resp_cmds));
+		ret = __iwl_mvm_add_int_sta_common(mvm, &tmp_sta, sta->addr,
+						   mvmvif->id, mvmvif->color,
+						   &batch);
+		if (!ret)
+			iwl_mvm_realloc_queues_after_restart(mvm, sta, &batch);
+		ret = iwl_mvm_cmd_batch_finish(&batch);
 		if (ret)
 			goto err;
 
-		iwl_mvm_realloc_queues_after_restart(mvm, sta);
 		sta_update = true;
 		sta_flags = iwl_mvm_has_new_tx_api(mvm) ? 0 : STA_MODIFY_QUEUES;
 		goto update_fw;
@@ -2688,6 +2750,49 @@ static void iwl_mvm_sync_rxq_del_ba(struct iwl_mvm *mvm, u8 baid)
 					&notif, sizeof(notif));
 };
 
+static void iwl_mvm_free_reorder_entries(struct iwl_mvm *mvm,
+					 struct iwl_mvm_baid_data *data)
+{
+	int i;
+
+	for (i = 0; i < mvm->trans->num_rx_queues; i++) {
+		kvfree(data->reorder_buf[i].entries);
+		data->reorder_buf[i].entries = NULL;
+		bitmap_free(data->reorder_buf[i].stored);
+		data->reorder_buf[i].stored = NULL;
+	}
+}
+
+/*
+ * Allocate the frame slots of all queues when the session is set up, so
+ * the RX path never allocates. With EHT they take several pages per queue.
+ */
+static int iwl_mvm_alloc_reorder_entries(struct iwl_mvm *mvm,
+					 struct iwl_mvm_baid_data *data,
+					 u16 buf_size)
+{
+	int i, j;
+
+	for (i = 0; i < mvm->trans->num_rx_queues; i++) {
+		struct iwl_mvm_reorder_buffer *reorder_buf =
+			&data->reorder_buf[i];
+
+		reorder_buf->entries =
+			kvmalloc_array(buf_size, sizeof(*reorder_buf->entries),
+				       GFP_KERNEL);
+		reorder_buf->stored = bitmap_zalloc(buf_size, GFP_KERNEL);
+		if (!reorder_buf->entries || !reorder_buf->stored) {
+			iwl_mvm_free_reorder_entries(mvm, data);
+			return -ENOMEM;
+		}
+
+		for (j = 0; j < buf_size; j++)
+			__skb_queue_head_init(&reorder_buf->entries[j]);
+	}
+
+	return 0;
+}
+
 static void iwl_mvm_free_reorder(struct iwl_mvm *mvm,
 				 struct iwl_mvm_baid_data *data)
 {
@@ -2696,30 +2801,25 @@ static void iwl_mvm_free_reorder(struct iwl_mvm *mvm,
 	iwl_mvm_sync_rxq_del_ba(mvm, data->baid);
 
 	for (i = 0; i < mvm->trans->num_rx_queues; i++) {
-		int j;
+		unsigned long j;
 		struct iwl_mvm_reorder_buffer *reorder_buf =
 			&data->reorder_buf[i];
-		struct iwl_mvm_reorder_buf_entry *entries =
-			&data->entries[i * data->entries_per_queue];
 
 		spin_lock_bh(&reorder_buf->lock);
-		if (likely(!reorder_buf->num_stored)) {
-			spin_unlock_bh(&reorder_buf->lock);
-			continue;
-		}
-
 		/*
-		 * This shouldn't happen in regular DELBA since the internal
-		 * delBA notification should trigger a release of all frames in
-		 * the reorder buffer.
+		 * Having frames stored shouldn't happen in regular DELBA since
+		 * the internal delBA notification should trigger a release of
+		 * all frames in the reorder buffer.
 		 */
-		WARN_ON(1);
-
-		for (j = 0; j < reorder_buf->buf_size; j++)
-			__skb_queue_purge(&entries[j].frames);
-
+		if (WARN_ON(reorder_buf->num_stored)) {
+			for_each_set_bit(j, reorder_buf->stored,
+					 reorder_buf->buf_size)
+				__skb_queue_purge(&reorder_buf->entries[j]);
+		}
 		spin_unlock_bh(&reorder_buf->lock);
 	}
+
+	iwl_mvm_free_reorder_entries(mvm, data);
 }
 
 static void iwl_mvm_init_reorder_buffer(struct iwl_mvm *mvm,
@@ -2731,9 +2831,6 @@ static void iwl_mvm_init_reorder_buffer(struct iwl_mvm *mvm,
 	for (i = 0; i < mvm->trans->num_rx_queues; i++) {
 		struct iwl_mvm_reorder_buffer *reorder_buf =
 			&data->reorder_buf[i];
-		struct iwl_mvm_reorder_buf_entry *entries =
-			&data->entries[i * data->entries_per_queue];
-		int j;
 
 		reorder_buf->num_stored = 0;
 		reorder_buf->head_sn = ssn;
@@ -2742,8 +2839,6 @@ static void iwl_mvm_init_reorder_buffer(struct iwl_mvm *mvm,
 		reorder_buf->mvm = mvm;
 		reorder_buf->queue = i;
 		reorder_buf->valid = false;
-		for (j = 0; j < reorder_buf->buf_size; j++)
-			__skb_queue_head_init(&entries[j].frames);
 	}
 }
 
@@ -2875,44 +2970,21 @@ int iwl_mvm_sta_rx_agg(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 	}
 
 	if (iwl_mvm_has_new_rx_api(mvm) && start) {
-		u32 reorder_buf_size = buf_size * sizeof(baid_data->entries[0]);
-
-		/* sparse doesn't like the __align() so don't check */
-#ifndef __CHECKER__
-		/*
-		 * The division below will be OK if either the cache line size
-		 * can be divided by the entry size (ALIGN will round up) or if
-		 * if the entry size can be divided by the cache line size, in
-		 * which case the ALIGN() will do nothing.
-		 */
-		BUILD_BUG_ON(SMP_CACHE_BYTES % sizeof(baid_data->entries[0]) &&
-			     sizeof(baid_data->entries[0]) % SMP_CACHE_BYTES);
-#endif
-
-		/*
-		 * Upward align the reorder buffer size to fill an entire cache
-		 * line for each queue, to avoid sharing cache lines between
-		 * different queues.
-		 */
-		reorder_buf_size = ALIGN(reorder_buf_size, SMP_CACHE_BYTES);
+		if (WARN_ON(!buf_size ||
+			    buf_size > IEEE80211_MAX_AMPDU_BUF_EHT))
+			return -EINVAL;
 
 		/*
 		 * Allocate here so if allocation fails we can bail out early
 		 * before starting the BA session in the firmware
 		 */
-		baid_data = kzalloc(sizeof(*baid_data) +
-				    mvm->trans->num_rx_queues *
-				    reorder_buf_size,
-				    GFP_KERNEL);
+		baid_data = kzalloc(sizeof(*baid_data), GFP_KERNEL);
 		if (!baid_data)
 			return -ENOMEM;
 
-		/*
-		 * This division is why we need the above BUILD_BUG_ON(),
-		 * if that doesn't hold then this will not be right.
-		 */
-		baid_data->entries_per_queue =
-			reorder_buf_size / sizeof(baid_data->entries[0]);
+		ret = iwl_mvm_alloc_reorder_entries(mvm, baid_data, buf_size);
+		if (ret)
+			goto out_free;
 	}
 
 	if (iwl_mvm_has_new_rx_api(mvm) && !start) {
@@ -3001,6 +3073,8 @@ int iwl_mvm_sta_rx_agg(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 	return 0;
 
 out_free:
+	if (baid_data)
+		iwl_mvm_free_reorder_entries(mvm, baid_data);
 	kfree(baid_data);
 	return ret;
 }
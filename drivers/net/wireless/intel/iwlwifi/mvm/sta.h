@@ -17,6 +17,7 @@
 
 struct iwl_mvm;
 struct iwl_mvm_vif;
+struct iwl_mvm_cmd_batch;
 
 /**
  * DOC: DQA - Dynamic Queue Allocation -introduction
@@ -482,7 +483,8 @@ static inline int iwl_mvm_update_sta(struct iwl_mvm *mvm,
 }
 
 void iwl_mvm_realloc_queues_after_restart(struct iwl_mvm *mvm,
-					  struct ieee80211_sta *sta);
+					  struct ieee80211_sta *sta,
+					  struct iwl_mvm_cmd_batch *batch);
 int iwl_mvm_wait_sta_queues_empty(struct iwl_mvm *mvm,
 				  struct iwl_mvm_sta *mvm_sta);
 bool iwl_mvm_sta_del(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/*
+ * KUnit tests for the iwlmvm RX reorder buffer
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include "../mvm.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+struct reorder_frame {
+	u16 sn;
+	u8 subframe;
+};
+
+struct reorder_case {
+	const char *desc;
+	u16 buf_size;
+	u16 head_sn;
+	const struct reorder_frame *stored;
+	unsigned int n_stored;
+	/* up to two releases, e.g. a BAR followed by a regular release */
+	u16 nssn[2];
+	unsigned int n_nssn;
+	const struct reorder_frame *released[2];
+	unsigned int n_released[2];
+};
+
+#define FRAMES(...) (const struct reorder_frame[]){ __VA_ARGS__ }
+
+static const struct reorder_case reorder_cases[] = {
+	{
+		.desc = "in order",
+		.buf_size = 64,
+		.head_sn = 10,
+		.stored = FRAMES({ 10 }, { 11 }, { 12 }),
+		.n_stored = 3,
+		.nssn = { 13 },
+		.n_nssn = 1,
+		.released = { FRAMES({ 10 }, { 11 }, { 12 }) },
+		.n_released = { 3 },
+	},
+	{
+		.desc = "out of order",
+		.buf_size = 64,
+		.head_sn = 0,
+		.stored = FRAMES({ 3 }, { 1 }, { 2 }, { 0 }),
+		.n_stored = 4,
+		.nssn = { 4 },
+		.n_nssn = 1,
+		.released = { FRAMES({ 0 }, { 1 }, { 2 }, { 3 }) },
+		.n_released = { 4 },
+	},
+	{
+		.desc = "hole stays buffered",
+		.buf_size = 64,
+		.head_sn = 0,
+		.stored = FRAMES({ 1 }, { 3 }, { 5 }),
+		.n_stored = 3,
+		.nssn = { 3, 6 },
+		.n_nssn = 2,
+		.released = { FRAMES({ 1 }), FRAMES({ 3 }, { 5 }) },
+		.n_released = { 1, 2 },
+	},
+	{
+		.desc = "A-MSDU subframes",
+		.buf_size = 64,
+		.head_sn = 20,
+		.stored = FRAMES({ 21, 0 }, { 20, 0 }, { 21, 1 }, { 21, 2 }),
+		.n_stored = 4,
+		.nssn = { 22 },
+		.n_nssn = 1,
+		.released = {
+			FRAMES({ 20, 0 }, { 21, 0 }, { 21, 1 }, { 21, 2 }),
+		},
+		.n_released = { 4 },
+	},
+	{
+		.desc = "slot wrap-around",
+		.buf_size = 64,
+		.head_sn = 60,
+		.stored = FRAMES({ 66 }, { 61 }, { 63 }, { 64 }),
+		.n_stored = 4,
+		.nssn = { 67 },
+		.n_nssn = 1,
+		.released = { FRAMES({ 61 }, { 63 }, { 64 }, { 66 }) },
+		.n_released = { 4 },
+	},
+	{
+		.desc = "sequence number wrap-around",
+		.buf_size = 256,
+		.head_sn = 4090,
+		.stored = FRAMES({ 2 }, { 4094 }, { 0 }, { 4091 }),
+		.n_stored = 4,
+		.nssn = { 3 },
+		.n_nssn = 1,
+		.released = { FRAMES({ 4091 }, { 4094 }, { 0 }, { 2 }) },
+		.n_released = { 4 },
+	},
+	{
+		/* 100 doesn't divide 4096, slots 0-9 follow slot 95 here */
+		.desc = "sequence number wrap-around, odd buffer size",
+		.buf_size = 100,
+		.head_sn = 4090,
+		.stored = FRAMES({ 9 }, { 4095 }, { 6 }, { 0 }, { 4090 }),
+		.n_stored = 5,
+		.nssn = { 10 },
+		.n_nssn = 1,
+		.released = {
+			FRAMES({ 4090 }, { 4095 }, { 0 }, { 6 }, { 9 }),
+		},
+		.n_released = { 5 },
+	},
+	{
+		.desc = "BAR moves the window",
+		.buf_size = 256,
+		.head_sn = 100,
+		.stored = FRAMES({ 101 }, { 110 }, { 200 }),
+		.n_stored = 3,
+		.nssn = { 150, 201 },
+		.n_nssn = 2,
+		.released = { FRAMES({ 101 }, { 110 }), FRAMES({ 200 }) },
+		.n_released = { 2, 1 },
+	},
+	{
+		.desc = "release whole EHT window",
+		.buf_size = 1024,
+		.head_sn = 4000,
+		.stored = FRAMES({ 4095 }, { 927 }, { 4000 }, { 0 }),
+		.n_stored = 4,
+		.nssn = { (4000 + 1024) & IEEE80211_SN_MASK },
+		.n_nssn = 1,
+		.released = { FRAMES({ 4000 }, { 4095 }, { 0 }, { 927 }) },
+		.n_released = { 4 },
+	},
+	{
+		.desc = "NSSN behind head",
+		.buf_size = 64,
+		.head_sn = 30,
+		.stored = FRAMES({ 31 }),
+		.n_stored = 1,
+		.nssn = { 28, 32 },
+		.n_nssn = 2,
+		.released = { NULL, FRAMES({ 31 }) },
+		.n_released = { 0, 1 },
+	},
+};
+
+KUNIT_ARRAY_PARAM_DESC(reorder, reorder_cases, desc);
+
+static struct sk_buff *reorder_frame_alloc(struct kunit *test,
+					   const struct reorder_frame *frame)
+{
+	struct sk_buff *skb = alloc_skb(0, GFP_KERNEL);
+
+	KUNIT_ASSERT_NOT_NULL(test, skb);
+	memcpy(skb->cb, frame, sizeof(*frame));
+
+	return skb;
+}
+
+static void reorder_buf_init(struct kunit *test,
+			     struct iwl_mvm_reorder_buffer *buf)
+{
+	int i;
+
+	buf->entries = kunit_kcalloc(test, buf->buf_size,
+				     sizeof(*buf->entries), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf->entries);
+
+	buf->stored = kunit_kcalloc(test, BITS_TO_LONGS(buf->buf_size),
+				    sizeof(*buf->stored), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf->stored);
+
+	for (i = 0; i < buf->buf_size; i++)
+		__skb_queue_head_init(&buf->entries[i]);
+}
+
+static void reorder_release(struct kunit *test)
+{
+	const struct reorder_case *params = test->param_value;
+	struct iwl_mvm_reorder_buffer buf = {
+		.buf_size = params->buf_size,
+		.head_sn = params->head_sn,
+	};
+	struct sk_buff_head frames;
+	unsigned int i, j;
+
+	reorder_buf_init(test, &buf);
+
+	for (i = 0; i < params->n_stored; i++) {
+		const struct reorder_frame *frame = &params->stored[i];
+
+		iwl_mvm_reorder_buf_store(&buf, frame->sn,
+					  reorder_frame_alloc(test, frame));
+	}
+	KUNIT_EXPECT_EQ(test, buf.num_stored, params->n_stored);
+
+	__skb_queue_head_init(&frames);
+
+	for (i = 0; i < params->n_nssn; i++) {
+		struct sk_buff *skb;
+
+		iwl_mvm_reorder_buf_release(&buf, params->nssn[i], &frames);
+		KUNIT_EXPECT_EQ(test, buf.head_sn, params->nssn[i]);
+		KUNIT_EXPECT_EQ(test, skb_queue_len(&frames),
+				params->n_released[i]);
+
+		for (j = 0; (skb = __skb_dequeue(&frames)); j++) {
+			const struct reorder_frame *frame = (void *)skb->cb;
+
+			if (j < params->n_released[i]) {
+				const struct reorder_frame *exp =
+					&params->released[i][j];
+
+				KUNIT_EXPECT_EQ(test, frame->sn, exp->sn);
+				KUNIT_EXPECT_EQ(test, frame->subframe,
+						exp->subframe);
+			}
+			kfree_skb(skb);
+		}
+	}
+
+	KUNIT_EXPECT_EQ(test, buf.num_stored, 0);
+	KUNIT_EXPECT_TRUE(test, bitmap_empty(buf.stored, buf.buf_size));
+}
+
+static struct kunit_case reorder_test_cases[] = {
+	KUNIT_CASE_PARAM(reorder_release, reorder_gen_params),
+	{}
+};
+
+static struct kunit_suite reorder_suite = {
+	.name = "iwlmvm-reorder",
+	.test_cases = reorder_test_cases,
+};
+
+kunit_test_suite(reorder_suite);
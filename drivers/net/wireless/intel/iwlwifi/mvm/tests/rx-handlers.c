@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/*
+ * KUnit tests for the iwlmvm notification handler lookup
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include "../mvm.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+static void rx_handlers_lookup(struct kunit *test)
+{
+	struct iwl_mvm_rx_handler_map map;
+	int idx;
+
+	KUNIT_ASSERT_EQ(test, 0,
+			iwl_mvm_rx_handler_map_init(&map, iwl_mvm_rx_handlers,
+						    iwl_mvm_rx_handlers_size));
+
+	for (idx = 0; idx < iwl_mvm_rx_handlers_size; idx++) {
+		const struct iwl_rx_handlers *rx_h = &iwl_mvm_rx_handlers[idx];
+		const struct iwl_rx_handlers *ret, *first = NULL;
+		int i;
+
+		/* the linear search used to find the first matching entry */
+		for (i = 0; i < iwl_mvm_rx_handlers_size; i++) {
+			if (iwl_mvm_rx_handlers[i].cmd_id == rx_h->cmd_id) {
+				first = &iwl_mvm_rx_handlers[i];
+				break;
+			}
+		}
+
+		ret = iwl_mvm_rx_handler_map_lookup(&map, rx_h->cmd_id);
+		if (ret != first)
+			KUNIT_FAIL(test,
+				   "entry %d (0x%04x) resolved to %pS instead of %pS\n",
+				   idx, rx_h->cmd_id, ret ? ret->fn : NULL,
+				   first->fn);
+	}
+
+	iwl_mvm_rx_handler_map_free(&map);
+}
+
+static void rx_handlers_unknown(struct kunit *test)
+{
+	struct iwl_mvm_rx_handler_map map;
+	int grp, cmd;
+
+	KUNIT_ASSERT_EQ(test, 0,
+			iwl_mvm_rx_handler_map_init(&map, iwl_mvm_rx_handlers,
+						    iwl_mvm_rx_handlers_size));
+
+	for (grp = 0; grp <= U8_MAX; grp++) {
+		for (cmd = 0; cmd <= U8_MAX; cmd++) {
+			u16 cmd_id = WIDE_ID(grp, cmd);
+			bool known = false;
+			int i;
+
+			for (i = 0; i < iwl_mvm_rx_handlers_size; i++) {
+				if (iwl_mvm_rx_handlers[i].cmd_id == cmd_id) {
+					known = true;
+					break;
+				}
+			}
+
+			if (known)
+				continue;
+
+			if (iwl_mvm_rx_handler_map_lookup(&map, cmd_id))
+				KUNIT_FAIL(test,
+					   "unknown ID 0x%04x has a handler\n",
+					   cmd_id);
+		}
+	}
+
+	iwl_mvm_rx_handler_map_free(&map);
+}
+
+static struct kunit_case rx_handlers_test_cases[] = {
+	KUNIT_CASE(rx_handlers_lookup),
+	KUNIT_CASE(rx_handlers_unknown),
+	{}
+};
+
+static struct kunit_suite iwlmvm_rx_handlers = {
+	.name = "iwlmvm-rx-handlers",
+	.test_cases = rx_handlers_test_cases,
+};
+
+kunit_test_suite(iwlmvm_rx_handlers);
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/*
+ * KUnit tests for splitting GSO skbs into A-MSDU MPDUs
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include <linux/ip.h>
+#include <linux/tcp.h>
+#include <net/checksum.h>
+#include "../mvm.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+#define TSO_MAX_FRAGS	4
+
+struct tso_split_case {
+	const char *desc;
+	unsigned int mss;
+	unsigned int num_subframes;
+	unsigned int frags[TSO_MAX_FRAGS];
+	unsigned int n_frags;
+	unsigned int n_mpdus;
+};
+
+static const struct tso_split_case tso_split_cases[] = {
+	{
+		.desc = "even split",
+		.mss = 1000,
+		.num_subframes = 3,
+		.frags = { 4000, 4000, 1000 },
+		.n_frags = 3,
+		.n_mpdus = 3,
+	},
+	{
+		.desc = "single subframe remainder",
+		.mss = 1000,
+		.num_subframes = 2,
+		.frags = { 3000, 1500 },
+		.n_frags = 2,
+		.n_mpdus = 3,
+	},
+	{
+		.desc = "MPDUs across fragments",
+		.mss = 1448,
+		.num_subframes = 4,
+		.frags = { 1000, 4096, 4096, 100 },
+		.n_frags = 4,
+		.n_mpdus = 2,
+	},
+	{
+		.desc = "short tail",
+		.mss = 1000,
+		.num_subframes = 3,
+		.frags = { 3000, 100 },
+		.n_frags = 2,
+		.n_mpdus = 2,
+	},
+	{
+		.desc = "no A-MSDU",
+		.mss = 1000,
+		.num_subframes = 1,
+		.frags = { 2500 },
+		.n_frags = 1,
+		.n_mpdus = 3,
+	},
+};
+
+KUNIT_ARRAY_PARAM_DESC(tso_split, tso_split_cases, desc);
+
+#define TSO_IP_ID	100
+#define TSO_SEQ		0xfffff000
+
+static struct sk_buff *tso_skb_alloc(struct kunit *test,
+				     const struct tso_split_case *params)
+{
+	static const u8 snap[] = { 0xaa, 0xaa, 0x03, 0, 0, 0, 0x08, 0x00 };
+	struct ieee80211_qos_hdr *hdr;
+	struct sk_buff *skb;
+	struct iphdr *iph;
+	struct tcphdr *th;
+	unsigned int i, offs = 0;
+
+	skb = alloc_skb(256, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, skb);
+	skb_reserve(skb, 64);
+
+	hdr = skb_put_zero(skb, sizeof(*hdr));
+	hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA |
+					 IEEE80211_STYPE_QOS_DATA);
+	hdr->qos_ctrl = cpu_to_le16(IEEE80211_QOS_CTL_A_MSDU_PRESENT);
+	skb_put_data(skb, snap, sizeof(snap));
+
+	skb_set_network_header(skb, skb->len);
+	iph = skb_put_zero(skb, sizeof(*iph));
+	iph->version = 4;
+	iph->ihl = 5;
+	iph->protocol = IPPROTO_TCP;
+	iph->id = htons(TSO_IP_ID);
+
+	skb_set_transport_header(skb, skb->len);
+	th = skb_put_zero(skb, sizeof(*th));
+	th->doff = sizeof(*th) / 4;
+	th->seq = htonl(TSO_SEQ);
+	th->cwr = 1;
+	th->psh = 1;
+	th->fin = 1;
+
+	skb->protocol = htons(ETH_P_IP);
+
+	for (i = 0; i < params->n_frags; i++) {
+		struct page *page = alloc_page(GFP_KERNEL);
+		unsigned int j;
+		u8 *data;
+
+		KUNIT_ASSERT_NOT_NULL(test, page);
+		data = page_address(page);
+		for (j = 0; j < params->frags[i]; j++)
+			data[j] = offs + j;
+		offs += params->frags[i];
+
+		skb_fill_page_desc(skb, i, page, 0, params->frags[i]);
+		skb->len += params->frags[i];
+		skb->data_len += params->frags[i];
+		skb->truesize += PAGE_SIZE;
+	}
+
+	skb_shinfo(skb)->gso_size = params->mss;
+	skb_shinfo(skb)->gso_type = SKB_GSO_TCPV4;
+
+	return skb;
+}
+
+static void tso_split(struct kunit *test)
+{
+	const struct tso_split_case *params = test->param_value;
+	unsigned int mpdu_len = params->mss * params->num_subframes;
+	unsigned int i, payload_len = 0, offs = 0;
+	struct sk_buff_head mpdus;
+	struct sk_buff *skb, *mpdu;
+	u8 *payload;
+
+	for (i = 0; i < params->n_frags; i++)
+		payload_len += params->frags[i];
+
+	payload = kunit_kzalloc(test, mpdu_len, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, payload);
+
+	skb = tso_skb_alloc(test, params);
+	__skb_queue_head_init(&mpdus);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			iwl_mvm_tx_tso_split(skb, params->num_subframes,
+					     &mpdus));
+	KUNIT_EXPECT_EQ(test, skb_queue_len(&mpdus), params->n_mpdus);
+	/* the original skb is sent last, to keep the socket accounting */
+	KUNIT_EXPECT_PTR_EQ(test, skb_peek_tail(&mpdus), skb);
+
+	for (i = 0; (mpdu = __skb_dequeue(&mpdus)); i++) {
+		unsigned int len = min(mpdu_len, payload_len - offs);
+		bool last = skb_queue_empty(&mpdus);
+		bool amsdu = len > params->mss;
+		struct tcphdr *th = tcp_hdr(mpdu);
+		struct iphdr *iph = ip_hdr(mpdu);
+		u8 *qc = ieee80211_get_qos_ctl((void *)mpdu->data);
+		unsigned int j;
+
+		KUNIT_EXPECT_EQ(test, mpdu->data_len, len);
+		KUNIT_EXPECT_EQ(test, skb_headlen(mpdu), skb_headlen(skb));
+		KUNIT_EXPECT_EQ(test,
+				!!(*qc & IEEE80211_QOS_CTL_A_MSDU_PRESENT),
+				amsdu);
+
+		if (amsdu) {
+			KUNIT_EXPECT_EQ(test, skb_shinfo(mpdu)->gso_size,
+					params->mss);
+			KUNIT_EXPECT_EQ(test, skb_shinfo(mpdu)->gso_segs,
+					DIV_ROUND_UP(len, params->mss));
+		} else {
+			/* sent as is, the headers must describe this frame */
+			KUNIT_EXPECT_EQ(test, skb_shinfo(mpdu)->gso_size, 0);
+			KUNIT_EXPECT_EQ(test, ntohs(iph->tot_len),
+					mpdu->len - skb_network_offset(mpdu));
+			KUNIT_EXPECT_FALSE(test, ip_fast_csum(iph, iph->ihl));
+		}
+
+		KUNIT_EXPECT_EQ(test, ntohs(iph->id),
+				TSO_IP_ID + i * params->num_subframes);
+		KUNIT_EXPECT_EQ(test, ntohl(th->seq), (u32)(TSO_SEQ + offs));
+		KUNIT_EXPECT_EQ(test, th->cwr, i == 0);
+		KUNIT_EXPECT_EQ(test, th->psh, last);
+		KUNIT_EXPECT_EQ(test, th->fin, last);
+
+		KUNIT_ASSERT_EQ(test, 0,
+				skb_copy_bits(mpdu, skb_headlen(mpdu),
+					      payload, len));
+		for (j = 0; j < len; j++)
+			if (payload[j] != (u8)(offs + j))
+				break;
+		KUNIT_EXPECT_EQ(test, j, len);
+
+		offs += len;
+		kfree_skb(mpdu);
+	}
+
+	KUNIT_EXPECT_EQ(test, offs, payload_len);
+}
+
+static struct kunit_case tso_test_cases[] = {
+	KUNIT_CASE_PARAM(tso_split, tso_split_gen_params),
+	{}
+};
+
+static struct kunit_suite tso_suite = {
+	.name = "iwlmvm-tso",
+	.test_cases = tso_test_cases,
+};
+
+kunit_test_suite(tso_suite);
@@ -10,6 +10,8 @@
 #include <net/gso.h>
 #include <net/ip.h>
 #include <net/ipv6.h>
+#include <net/ip6_checksum.h>
+#include <net/tcp.h>
 
 #include "iwl-trans.h"
 #include "iwl-eeprom-parse.h"
@@ -1007,6 +1009,195 @@ iwl_mvm_tx_tso_segment(struct sk_buff *skb, unsigned int num_subframes,
 	return 0;
 }
 
+/*
+ * An MPDU with a single subframe isn't sent as an A-MSDU, so the
+ * transport doesn't build its headers. Make it a regular frame, like
+ * skb_gso_segment() does for a single segment.
+ */
+static void iwl_mvm_tx_tso_single_subframe(struct sk_buff *skb)
+{
+	unsigned int tcp_len = skb->len - skb_transport_offset(skb);
+	struct tcphdr *th = tcp_hdr(skb);
+	u8 *qc = ieee80211_get_qos_ctl((void *)skb->data);
+
+	*qc &= ~IEEE80211_QOS_CTL_A_MSDU_PRESENT;
+	skb_shinfo(skb)->gso_size = 0;
+
+	if (skb->protocol == htons(ETH_P_IP)) {
+		struct iphdr *iph = ip_hdr(skb);
+
+		iph->tot_len = htons(skb->len - skb_network_offset(skb));
+		ip_send_check(iph);
+		if (skb->ip_summed == CHECKSUM_PARTIAL)
+			th->check = ~tcp_v4_check(tcp_len, iph->saddr,
+						  iph->daddr, 0);
+	} else {
+		struct ipv6hdr *ip6h = ipv6_hdr(skb);
+
+		ip6h->payload_len = htons(skb->len - skb_network_offset(skb) -
+					  sizeof(*ip6h));
+		if (skb->ip_summed == CHECKSUM_PARTIAL)
+			th->check = ~tcp_v6_check(tcp_len, &ip6h->saddr,
+						  &ip6h->daddr, 0);
+	}
+}
+
+static void iwl_mvm_tx_tso_fixup_hdrs(struct sk_buff *skb, u16 ip_id,
+				      u32 seq, unsigned int mss,
+				      bool first, bool last)
+{
+	struct tcphdr *th = tcp_hdr(skb);
+
+	if (skb->protocol == htons(ETH_P_IP))
+		ip_hdr(skb)->id = htons(ip_id);
+
+	th->seq = htonl(seq);
+	if (!first)
+		th->cwr = 0;
+	if (!last)
+		th->fin = th->psh = 0;
+
+	if (skb->data_len <= mss)
+		iwl_mvm_tx_tso_single_subframe(skb);
+	else
+		skb_shinfo(skb)->gso_segs = DIV_ROUND_UP(skb->data_len, mss);
+}
+
+/* Create an MPDU with a copy of the headers of @skb and @len bytes of its
+ * fragments, starting at fragment *@frag, offset *@frag_offs.
+ */
+static struct sk_buff *
+iwl_mvm_tx_tso_split_mpdu(struct sk_buff *skb, unsigned int *frag,
+			  unsigned int *frag_offs, unsigned int len)
+{
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
+	struct sk_buff *nskb;
+	int i = 0;
+
+	nskb = alloc_skb(skb_headroom(skb) + skb_headlen(skb), GFP_ATOMIC);
+	if (!nskb)
+		return NULL;
+
+	skb_reserve(nskb, skb_headroom(skb));
+	skb_put_data(nskb, skb->data, skb_headlen(skb));
+	skb_copy_header(nskb, skb);
+
+	while (len) {
+		skb_frag_t *f = &shinfo->frags[*frag];
+		unsigned int size = min(skb_frag_size(f) - *frag_offs, len);
+
+		__skb_frag_ref(f);
+		skb_fill_page_desc(nskb, i++, skb_frag_page(f),
+				   skb_frag_off(f) + *frag_offs, size);
+		nskb->len += size;
+		nskb->data_len += size;
+		nskb->truesize += size;
+		len -= size;
+
+		*frag_offs += size;
+		if (*frag_offs == skb_frag_size(f)) {
+			(*frag)++;
+			*frag_offs = 0;
+		}
+	}
+
+	return nskb;
+}
+
+/* Drop the first @len bytes of the fragments of @skb */
+static void iwl_mvm_tx_tso_pull_frags(struct sk_buff *skb, unsigned int len)
+{
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
+	unsigned int pull = len;
+	int i, k = 0;
+
+	for (i = 0; i < shinfo->nr_frags; i++) {
+		skb_frag_t *f = &shinfo->frags[i];
+
+		if (pull >= skb_frag_size(f)) {
+			pull -= skb_frag_size(f);
+			skb_frag_unref(skb, i);
+			continue;
+		}
+
+		shinfo->frags[k] = *f;
+		if (pull) {
+			skb_frag_off_add(&shinfo->frags[k], pull);
+			skb_frag_size_sub(&shinfo->frags[k], pull);
+			pull = 0;
+		}
+		k++;
+	}
+
+	shinfo->nr_frags = k;
+	skb->len -= len;
+	skb->data_len -= len;
+}
+
+/*
+ * Split a GSO skb into MPDUs of up to @num_subframes subframes each,
+ * without going through skb_gso_segment(). This is only possible when
+ * the whole TCP payload is in page fragments. Each MPDU gets a copy of
+ * the headers, with the TCP sequence number and IP ID of its first
+ * subframe, and shares the fragments of the original skb: the transport
+ * builds the subframe headers itself (see tso_build_hdr()), exactly as
+ * it does for a GSO skb that fits a single A-MSDU. An MPDU that ends up
+ * with a single subframe, e.g. the last one, is made a regular frame.
+ *
+ * The original skb becomes the last MPDU, so it stays accounted to its
+ * socket.
+ */
+VISIBLE_IF_IWLWIFI_KUNIT int
+iwl_mvm_tx_tso_split(struct sk_buff *skb, unsigned int num_subframes,
+		     struct sk_buff_head *mpdus_skb)
+{
+	unsigned int mss = skb_shinfo(skb)->gso_size;
+	unsigned int mpdu_len = num_subframes * mss;
+	unsigned int frag = 0, frag_offs = 0, offs = 0;
+	bool ipv4 = skb->protocol == htons(ETH_P_IP);
+	struct sk_buff_head mpdus;
+	u16 ip_id;
+	u32 seq;
+	u16 i;
+
+	if (WARN_ON_ONCE(!mpdu_len))
+		return -EINVAL;
+
+	if (skb_unclone(skb, GFP_ATOMIC))
+		return -ENOMEM;
+
+	ip_id = ipv4 ? ntohs(ip_hdr(skb)->id) : 0;
+	seq = ntohl(tcp_hdr(skb)->seq);
+
+	__skb_queue_head_init(&mpdus);
+
+	for (i = 0; skb->data_len - offs > mpdu_len; i++) {
+		struct sk_buff *nskb;
+
+		nskb = iwl_mvm_tx_tso_split_mpdu(skb, &frag, &frag_offs,
+						 mpdu_len);
+		if (!nskb) {
+			__skb_queue_purge(&mpdus);
+			return -ENOMEM;
+		}
+
+		iwl_mvm_tx_tso_fixup_hdrs(nskb, ip_id + i * num_subframes,
+					  seq + offs, mss, !i, false);
+		__skb_queue_tail(&mpdus, nskb);
+		offs += mpdu_len;
+	}
+
+	iwl_mvm_tx_tso_pull_frags(skb, offs);
+	iwl_mvm_tx_tso_fixup_hdrs(skb, ip_id + i * num_subframes, seq + offs,
+				  mss, !i, true);
+	__skb_queue_tail(&mpdus, skb);
+
+	skb_queue_splice_tail(&mpdus, mpdus_skb);
+
+	return 0;
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_mvm_tx_tso_split);
+
 static int iwl_mvm_tx_tso(struct iwl_mvm *mvm, struct sk_buff *skb,
 			  struct ieee80211_tx_info *info,
 			  struct ieee80211_sta *sta,
@@ -1104,6 +1295,16 @@ static int iwl_mvm_tx_tso(struct iwl_mvm *mvm, struct sk_buff *skb,
 		return 0;
 	}
 
+	/*
+	 * If all of the payload is in fragments, the MPDUs can simply share
+	 * them, the transport builds the subframes from the original headers.
+	 * That only works for A-MSDUs.
+	 */
+	if (num_subframes > 1 &&
+	    !skb_has_frag_list(skb) && !skb_zcopy(skb) &&
+	    skb_headlen(skb) == skb_transport_offset(skb) + tcp_hdrlen(skb))
+		return iwl_mvm_tx_tso_split(skb, num_subframes, mpdus_skb);
+
 	/*
 	 * Trick the segmentation function to make it
 	 * create SKBs that can fit into one A-MSDU.
@@ -1143,12 +1344,43 @@ static bool iwl_mvm_txq_should_update(struct iwl_mvm *mvm, int txq_id)
 	return false;
 }
 
+/* must be called under RCU */
+static struct iwl_mvm_tcm_link *
+iwl_mvm_tx_tcm_link(struct iwl_mvm *mvm, struct iwl_mvm_sta *mvmsta,
+		    int sta_id)
+{
+	struct iwl_mvm_vif *mvmvif = iwl_mvm_vif_from_mac80211(mvmsta->vif);
+	struct iwl_mvm_vif_link_info *link_info = &mvmvif->deflink;
+	unsigned int idx;
+
+	if (iwl_mvm_has_mld_api(mvm->fw)) {
+		struct ieee80211_link_sta *link_sta;
+
+		link_sta = rcu_dereference(mvm->fw_id_to_link_sta[sta_id]);
+		if (IS_ERR_OR_NULL(link_sta))
+			return NULL;
+
+		link_info = mvmvif->link[link_sta->link_id];
+		if (!link_info)
+			return NULL;
+	}
+
+	idx = iwl_mvm_tcm_link_idx(mvm, mvmvif, link_info);
+	if (idx >= ARRAY_SIZE(mvm->tcm.link))
+		return NULL;
+
+	return &mvm->tcm.link[idx];
+}
+
 static void iwl_mvm_tx_airtime(struct iwl_mvm *mvm,
 			       struct iwl_mvm_sta *mvmsta,
+			       int sta_id, int tid, int frames,
 			       int airtime)
 {
 	int mac = mvmsta->mac_id_n_color & FW_CTXT_ID_MSK;
+	struct iwl_mvm_tcm_link *ldata;
 	struct iwl_mvm_tcm_mac *mdata;
+	int ac;
 
 	if (mac >= NUM_MAC_INDEX_DRIVER)
 		return;
@@ -1158,10 +1390,20 @@ static void iwl_mvm_tx_airtime(struct iwl_mvm *mvm,
 	if (mvm->tcm.paused)
 		return;
 
-	if (time_after(jiffies, mvm->tcm.ts + MVM_TCM_PERIOD))
+	if (time_after(jiffies, mvm->tcm.ts + mvm->tcm.period))
 		schedule_delayed_work(&mvm->tcm.work, 0);
 
 	mdata->tx.airtime += airtime;
+
+	ldata = iwl_mvm_tx_tcm_link(mvm, mvmsta, sta_id);
+	if (!ldata)
+		return;
+
+	/* management frames are treated as TID 8, which is AC_VO */
+	ac = tid <= IWL_MAX_TID_COUNT ? tid_to_mac80211_ac[tid] :
+					IEEE80211_AC_VO;
+	ldata->pkts[ac] += frames;
+	ldata->airtime[ac] += airtime;
 }
 
 static int iwl_mvm_tx_pkt_queued(struct iwl_mvm *mvm,
@@ -1859,7 +2101,8 @@ static void iwl_mvm_rx_tx_cmd_single(struct iwl_mvm *mvm,
 	if (!IS_ERR(sta)) {
 		struct iwl_mvm_sta *mvmsta = iwl_mvm_sta_from_mac80211(sta);
 
-		iwl_mvm_tx_airtime(mvm, mvmsta,
+		iwl_mvm_tx_airtime(mvm, mvmsta, sta_id, tid,
+				   tx_resp->frame_count,
 				   le16_to_cpu(tx_resp->wireless_media_time));
 
 		if ((status & TX_STATUS_MSK) != TX_STATUS_SUCCESS &&
@@ -2016,7 +2259,8 @@ static void iwl_mvm_rx_tx_cmd_agg(struct iwl_mvm *mvm,
 			le16_to_cpu(tx_resp->wireless_media_time);
 		mvmsta->tid_data[tid].lq_color =
 			TX_RES_RATE_TABLE_COL_GET(tx_resp->tlc_info);
-		iwl_mvm_tx_airtime(mvm, mvmsta,
+		iwl_mvm_tx_airtime(mvm, mvmsta, sta_id, tid,
+				   tx_resp->frame_count,
 				   le16_to_cpu(tx_resp->wireless_media_time));
 	}
 
@@ -2034,6 +2278,27 @@ void iwl_mvm_rx_tx_cmd(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb)
 		iwl_mvm_rx_tx_cmd_agg(mvm, pkt);
 }
 
+/*
+ * Report a batch of frames reclaimed by a single BA notification. They all
+ * belong to the same station, so mac80211 can take them as a list instead
+ * of looking the station up by address for every single frame. Must be
+ * called under RCU, @sta may be %NULL if the station is being removed.
+ */
+static void iwl_mvm_tx_status_bulk(struct iwl_mvm *mvm,
+				   struct ieee80211_sta *sta,
+				   struct sk_buff_head *skbs)
+{
+	struct sk_buff *skb;
+
+	if (sta) {
+		ieee80211_tx_status_list(mvm->hw, sta, skbs);
+		return;
+	}
+
+	while ((skb = __skb_dequeue(skbs)))
+		ieee80211_tx_status_skb(mvm->hw, skb);
+}
+
 static void iwl_mvm_tx_reclaim(struct iwl_mvm *mvm, int sta_id, int tid,
 			       int txq, int index,
 			       struct ieee80211_tx_info *tx_info, u32 rate,
@@ -2173,12 +2438,8 @@ static void iwl_mvm_tx_reclaim(struct iwl_mvm *mvm, int sta_id, int tid,
 	}
 
 out:
+	iwl_mvm_tx_status_bulk(mvm, IS_ERR(sta) ? NULL : sta, &reclaimed_skbs);
 	rcu_read_unlock();
-
-	while (!skb_queue_empty(&reclaimed_skbs)) {
-		skb = __skb_dequeue(&reclaimed_skbs);
-		ieee80211_tx_status_skb(mvm->hw, skb);
-	}
 }
 
 void iwl_mvm_rx_ba_notif(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb)
@@ -2254,7 +2515,8 @@ void iwl_mvm_rx_ba_notif(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb)
 		}
 
 		if (mvmsta)
-			iwl_mvm_tx_airtime(mvm, mvmsta,
+			iwl_mvm_tx_airtime(mvm, mvmsta, sta_id, tid,
+					   le16_to_cpu(ba_res->txed),
 					   le32_to_cpu(ba_res->wireless_time));
 		rcu_read_unlock();
 
@@ -67,6 +67,130 @@ int iwl_mvm_send_cmd_pdu(struct iwl_mvm *mvm, u32 id,
 	return iwl_mvm_send_cmd(mvm, &cmd);
 }
 
+static bool iwl_mvm_cmd_batch_resp(struct iwl_notif_wait_data *notif_wait,
+				   struct iwl_rx_packet *pkt, void *data)
+{
+	struct iwl_mvm_cmd_batch *batch = data;
+	u16 seq = le16_to_cpu(pkt->hdr.sequence);
+	int i, ret;
+
+	spin_lock(&batch->lock);
+	for (i = 0; i < batch->n_resp; i++) {
+		if (batch->resp[i].seq != seq)
+			continue;
+
+		ret = batch->resp[i].fn(batch->mvm, pkt, batch->resp[i].data);
+		if (ret && !batch->ret)
+			batch->ret = ret;
+		break;
+	}
+	spin_unlock(&batch->lock);
+
+	/* keep collecting until iwl_mvm_cmd_batch_finish() */
+	return false;
+}
+
+/*
+ * Start a batch of host commands. Responses to commands with one of the
+ * IDs in @resp_cmds can be handed to a callback, see
+ * iwl_mvm_cmd_batch_add().
+ */
+void iwl_mvm_cmd_batch_init(struct iwl_mvm *mvm,
+			    struct iwl_mvm_cmd_batch *batch,
+			    const u16 *resp_cmds, int n_resp_cmds)
+{
+	lockdep_assert_held(&mvm->mutex);
+
+	batch->mvm = mvm;
+	batch->n_resp = 0;
+	batch->ret = 0;
+	spin_lock_init(&batch->lock);
+
+	iwl_init_notification_wait(&mvm->notif_wait, &batch->wait,
+				   resp_cmds, n_resp_cmds,
+				   iwl_mvm_cmd_batch_resp, batch);
+}
+
+/*
+ * Queue a command of the batch. If @fn is given, it's called from the
+ * RX path with the response, so it must not sleep.
+ */
+int iwl_mvm_cmd_batch_add(struct iwl_mvm_cmd_batch *batch,
+			  struct iwl_host_cmd *cmd,
+			  int (*fn)(struct iwl_mvm *mvm,
+				    struct iwl_rx_packet *pkt, void *data),
+			  void *data)
+{
+	int ret;
+
+	if (WARN_ON(cmd->flags & CMD_WANT_SKB))
+		return -EINVAL;
+
+	cmd->flags |= CMD_ASYNC;
+
+	if (!fn)
+		goto send;
+
+	if (WARN_ON(batch->n_resp >= ARRAY_SIZE(batch->resp)))
+		return -ENOSPC;
+
+	/*
+	 * The response can arrive before the send returns, so hold the
+	 * lock until the sequence number is recorded.
+	 */
+	spin_lock_bh(&batch->lock);
+	ret = iwl_mvm_send_cmd(batch->mvm, cmd);
+	if (!ret) {
+		batch->resp[batch->n_resp].seq = cmd->seq;
+		batch->resp[batch->n_resp].fn = fn;
+		batch->resp[batch->n_resp].data = data;
+		batch->n_resp++;
+	}
+	spin_unlock_bh(&batch->lock);
+	goto out;
+
+send:
+	ret = iwl_mvm_send_cmd(batch->mvm, cmd);
+out:
+	if (ret && !batch->ret)
+		batch->ret = ret;
+	return ret;
+}
+
+int iwl_mvm_cmd_batch_add_pdu(struct iwl_mvm_cmd_batch *batch, u32 id,
+			      u32 flags, u16 len, const void *data,
+			      int (*fn)(struct iwl_mvm *mvm,
+					struct iwl_rx_packet *pkt,
+					void *fn_data),
+			      void *fn_data)
+{
+	struct iwl_host_cmd cmd = {
+		.id = id,
+		.len = { len, },
+		.data = { data, },
+		.flags = flags,
+	};
+
+	return iwl_mvm_cmd_batch_add(batch, &cmd, fn, fn_data);
+}
+
+/*
+ * Wait for all the commands of the batch. The firmware handles host
+ * commands in order, so once the response to a synchronous echo arrives
+ * all the responses of the batch went through the RX path.
+ */
+int iwl_mvm_cmd_batch_finish(struct iwl_mvm_cmd_batch *batch)
+{
+	struct iwl_mvm *mvm = batch->mvm;
+	int ret;
+
+	ret = iwl_mvm_send_cmd_pdu(mvm, ECHO_CMD, 0, 0, NULL);
+
+	iwl_remove_notification(&mvm->notif_wait, &batch->wait);
+
+	return batch->ret ?: ret;
+}
+
 /*
  * We assume that the caller set the status to the success value
  */
@@ -831,10 +955,8 @@ u8 iwl_mvm_tcm_load_percentage(u32 airtime, u32 elapsed)
 }
 
 static enum iwl_mvm_traffic_load
-iwl_mvm_tcm_load(struct iwl_mvm *mvm, u32 airtime, unsigned long elapsed)
+iwl_mvm_tcm_load_level(struct iwl_mvm *mvm, u32 load)
 {
-	u8 load = iwl_mvm_tcm_load_percentage(airtime, elapsed);
-
 	if (load > IWL_MVM_TCM_LOAD_HIGH_THRESH)
 		return IWL_MVM_TRAFFIC_HIGH;
 	if (load > IWL_MVM_TCM_LOAD_MEDIUM_THRESH)
@@ -843,6 +965,14 @@ iwl_mvm_tcm_load(struct iwl_mvm *mvm, u32 airtime, unsigned long elapsed)
 	return IWL_MVM_TRAFFIC_LOW;
 }
 
+static enum iwl_mvm_traffic_load
+iwl_mvm_tcm_load(struct iwl_mvm *mvm, u32 airtime, unsigned long elapsed)
+{
+	return iwl_mvm_tcm_load_level(mvm,
+				      iwl_mvm_tcm_load_percentage(airtime,
+								  elapsed));
+}
+
 static void iwl_mvm_tcm_iter(void *_data, u8 *mac, struct ieee80211_vif *vif)
 {
 	struct iwl_mvm *mvm = _data;
@@ -880,6 +1010,12 @@ static void iwl_mvm_tcm_results(struct iwl_mvm *mvm)
 	if (fw_has_capa(&mvm->fw->ucode_capa, IWL_UCODE_TLV_CAPA_UMAC_SCAN))
 		iwl_mvm_config_scan(mvm);
 
+#ifdef CPTCFG_IWLMVM_VENDOR_CMDS
+	if (memchr_inv(mvm->tcm.result.link_change, 0,
+		       sizeof(mvm->tcm.result.link_change)))
+		iwl_mvm_send_tcm_event(mvm);
+#endif
+
 	mutex_unlock(&mvm->mutex);
 }
 
@@ -990,6 +1126,30 @@ static void iwl_mvm_tcm_iterator(void *_data, u8 *mac,
 	band[mvmvif->id] = mvmvif->deflink.phy_ctxt->channel->band;
 }
 
+static enum iwl_mvm_traffic_load
+iwl_mvm_tcm_update_link(struct iwl_mvm *mvm, struct iwl_mvm_tcm_link *ldata,
+			unsigned int elapsed)
+{
+	u32 airtime = 0;
+	int ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		/* airtime is in usec, so this gives per mille of the period */
+		ewma_tcm_add(&ldata->airtime_avg[ac],
+			     ldata->airtime[ac] / elapsed);
+		ewma_tcm_add(&ldata->pkt_rate_avg[ac],
+			     ldata->pkts[ac] * MSEC_PER_SEC / elapsed);
+
+		airtime += ewma_tcm_read(&ldata->airtime_avg[ac]);
+	}
+
+	/* clear old data */
+	memset(&ldata->airtime, 0, sizeof(ldata->airtime));
+	memset(&ldata->pkts, 0, sizeof(ldata->pkts));
+
+	return iwl_mvm_tcm_load_level(mvm, airtime / 10);
+}
+
 static unsigned long iwl_mvm_calc_tcm_stats(struct iwl_mvm *mvm,
 					    unsigned long ts,
 					    bool handle_uapsd)
@@ -1001,8 +1161,8 @@ static unsigned long iwl_mvm_calc_tcm_stats(struct iwl_mvm *mvm,
 	u32 band_airtime[NUM_NL80211_BANDS] = {0};
 	u32 band[NUM_MAC_INDEX_DRIVER] = {0};
 	int ac, mac, i;
-	bool low_latency = false;
-	enum iwl_mvm_traffic_load load, band_load;
+	bool low_latency = false, link_busy = false;
+	enum iwl_mvm_traffic_load load, band_load, link_load;
 	bool handle_ll = time_after(ts, mvm->tcm.ll_ts + MVM_LL_PERIOD);
 
 	if (handle_ll)
@@ -1066,14 +1226,24 @@ static unsigned long iwl_mvm_calc_tcm_stats(struct iwl_mvm *mvm,
 		mvm->tcm.result.band_load[i] = band_load;
 	}
 
+	for (i = 0; i < ARRAY_SIZE(mvm->tcm.link); i++) {
+		link_load = iwl_mvm_tcm_update_link(mvm, &mvm->tcm.link[i],
+						    max(elapsed, 1U));
+		mvm->tcm.result.link_change[i] =
+			link_load != mvm->tcm.result.link_load[i];
+		mvm->tcm.result.link_load[i] = link_load;
+		link_busy |= link_load != IWL_MVM_TRAFFIC_LOW;
+	}
+
 	/*
 	 * If the current load isn't low we need to force re-evaluation
 	 * in the TCM period, so that we can return to low load if there
 	 * was no traffic at all (and thus iwl_mvm_recalc_tcm didn't get
-	 * triggered by traffic).
+	 * triggered by traffic). The same goes for the per-link averages,
+	 * which only decay when they're updated.
 	 */
-	if (load != IWL_MVM_TRAFFIC_LOW)
-		return MVM_TCM_PERIOD;
+	if (load != IWL_MVM_TRAFFIC_LOW || link_busy)
+		return mvm->tcm.period;
 	/*
 	 * If low-latency is active we need to force re-evaluation after
 	 * (the longer) MVM_LL_PERIOD, so that we can disable low-latency
@@ -1103,7 +1273,8 @@ void iwl_mvm_recalc_tcm(struct iwl_mvm *mvm)
 			       msecs_to_jiffies(IWL_MVM_UAPSD_NONAGG_PERIOD));
 
 	spin_lock(&mvm->tcm.lock);
-	if (mvm->tcm.paused || !time_after(ts, mvm->tcm.ts + MVM_TCM_PERIOD)) {
+	if (mvm->tcm.paused ||
+	    !time_after(ts, mvm->tcm.ts + mvm->tcm.period)) {
 		spin_unlock(&mvm->tcm.lock);
 		return;
 	}
@@ -1118,7 +1289,8 @@ void iwl_mvm_recalc_tcm(struct iwl_mvm *mvm)
 
 	spin_lock(&mvm->tcm.lock);
 	/* re-check if somebody else won the recheck race */
-	if (!mvm->tcm.paused && time_after(ts, mvm->tcm.ts + MVM_TCM_PERIOD)) {
+	if (!mvm->tcm.paused &&
+	    time_after(ts, mvm->tcm.ts + mvm->tcm.period)) {
 		/* calculate statistics */
 		unsigned long work_delay = iwl_mvm_calc_tcm_stats(mvm, ts,
 								  handle_uapsd);
@@ -1154,7 +1326,7 @@ void iwl_mvm_pause_tcm(struct iwl_mvm *mvm, bool with_cancel)
 
 void iwl_mvm_resume_tcm(struct iwl_mvm *mvm)
 {
-	int mac;
+	int mac, i;
 	bool low_latency = false;
 
 	spin_lock_bh(&mvm->tcm.lock);
@@ -1171,6 +1343,12 @@ void iwl_mvm_resume_tcm(struct iwl_mvm *mvm)
 		if (mvm->tcm.result.low_latency[mac])
 			low_latency = true;
 	}
+	for (i = 0; i < ARRAY_SIZE(mvm->tcm.link); i++) {
+		struct iwl_mvm_tcm_link *ldata = &mvm->tcm.link[i];
+
+		memset(&ldata->airtime, 0, sizeof(ldata->airtime));
+		memset(&ldata->pkts, 0, sizeof(ldata->pkts));
+	}
 	/* The TCM data needs to be reset before "paused" flag changes */
 	smp_mb();
 	mvm->tcm.paused = false;
@@ -1180,7 +1358,7 @@ void iwl_mvm_resume_tcm(struct iwl_mvm *mvm)
 	 * re-evaluation to cover the case of no traffic.
 	 */
 	if (mvm->tcm.result.global_load > IWL_MVM_TRAFFIC_LOW)
-		schedule_delayed_work(&mvm->tcm.work, MVM_TCM_PERIOD);
+		schedule_delayed_work(&mvm->tcm.work, mvm->tcm.period);
 	else if (low_latency)
 		schedule_delayed_work(&mvm->tcm.work, MVM_LL_PERIOD);
 
@@ -1193,6 +1371,10 @@ void iwl_mvm_tcm_add_vif(struct iwl_mvm *mvm, struct ieee80211_vif *vif)
 
 	INIT_DELAYED_WORK(&mvmvif->uapsd_nonagg_detected_wk,
 			  iwl_mvm_tcm_uapsd_nonagg_detected_wk);
+
+	/* with the MLD API this is done as links get their firmware ID */
+	if (!iwl_mvm_has_mld_api(mvm->fw))
+		iwl_mvm_tcm_reset_link(mvm, mvmvif->id);
 }
 
 void iwl_mvm_tcm_rm_vif(struct iwl_mvm *mvm, struct ieee80211_vif *vif)
@@ -1202,6 +1384,30 @@ void iwl_mvm_tcm_rm_vif(struct iwl_mvm *mvm, struct ieee80211_vif *vif)
 	cancel_delayed_work_sync(&mvmvif->uapsd_nonagg_detected_wk);
 }
 
+void iwl_mvm_tcm_reset_link(struct iwl_mvm *mvm, unsigned int idx)
+{
+	if (WARN_ON(idx >= ARRAY_SIZE(mvm->tcm.link)))
+		return;
+
+	spin_lock_bh(&mvm->tcm.lock);
+	memset(&mvm->tcm.link[idx], 0, sizeof(mvm->tcm.link[idx]));
+	mvm->tcm.result.link_load[idx] = IWL_MVM_TRAFFIC_LOW;
+	mvm->tcm.result.link_change[idx] = false;
+	spin_unlock_bh(&mvm->tcm.lock);
+}
+
+enum iwl_mvm_traffic_load
+iwl_mvm_tcm_link_load(struct iwl_mvm *mvm, struct iwl_mvm_vif *mvmvif,
+		      struct iwl_mvm_vif_link_info *link_info)
+{
+	unsigned int idx = iwl_mvm_tcm_link_idx(mvm, mvmvif, link_info);
+
+	if (idx >= ARRAY_SIZE(mvm->tcm.link))
+		return mvm->tcm.result.load[mvmvif->id];
+
+	return mvm->tcm.result.link_load[idx];
+}
+
 u32 iwl_mvm_get_systime(struct iwl_mvm *mvm)
 {
 	u32 reg_addr = DEVICE_SYSTEM_TIME_REG;
@@ -2079,6 +2079,7 @@ enum iwl_mvm_vendor_events_idx {
 	IWL_MVM_VENDOR_EVENT_IDX_TSM_CFM,
 	IWL_MVM_VENDOR_EVENT_IDX_TSM_MSMT,
 	IWL_MVM_VENDOR_EVENT_IDX_ROAMING_FORBIDDEN = 4,
+	IWL_MVM_VENDOR_EVENT_IDX_TCM,
 	NUM_IWL_MVM_VENDOR_EVENT_IDX
 };
 
@@ -2092,6 +2093,10 @@ iwl_mvm_vendor_events[NUM_IWL_MVM_VENDOR_EVENT_IDX] = {
 		.vendor_id = INTEL_OUI,
 		.subcmd = IWL_MVM_VENDOR_CMD_ROAMING_FORBIDDEN_EVENT,
 	},
+	[IWL_MVM_VENDOR_EVENT_IDX_TCM] = {
+		.vendor_id = INTEL_OUI,
+		.subcmd = IWL_MVM_VENDOR_CMD_TCM_EVENT,
+	},
 };
 
 void iwl_mvm_vendor_cmds_register(struct iwl_mvm *mvm)
@@ -2309,3 +2314,62 @@ void iwl_mvm_send_roaming_forbidden_event(struct iwl_mvm *mvm,
  nla_put_failure:
 	kfree_skb(msg);
 }
+
+void iwl_mvm_send_tcm_event(struct iwl_mvm *mvm)
+{
+	struct {
+		u8 load;
+		u32 airtime[IEEE80211_NUM_ACS];
+		u32 pkt_rate[IEEE80211_NUM_ACS];
+	} links[IWL_MVM_TCM_NUM_LINKS];
+	struct nlattr *nl_links;
+	struct sk_buff *msg;
+	int i, ac;
+
+	spin_lock_bh(&mvm->tcm.lock);
+	for (i = 0; i < ARRAY_SIZE(links); i++) {
+		struct iwl_mvm_tcm_link *ldata = &mvm->tcm.link[i];
+
+		links[i].load = mvm->tcm.result.link_load[i];
+		for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+			links[i].airtime[ac] =
+				ewma_tcm_read(&ldata->airtime_avg[ac]);
+			links[i].pkt_rate[ac] =
+				ewma_tcm_read(&ldata->pkt_rate_avg[ac]);
+		}
+	}
+	spin_unlock_bh(&mvm->tcm.lock);
+
+	msg = cfg80211_vendor_event_alloc(mvm->hw->wiphy, NULL, 400,
+					  IWL_MVM_VENDOR_EVENT_IDX_TCM,
+					  GFP_KERNEL);
+	if (!msg)
+		return;
+
+	nl_links = nla_nest_start(msg, IWL_MVM_VENDOR_ATTR_TCM_LINKS);
+	if (!nl_links)
+		goto nla_put_failure;
+
+	for (i = 0; i < ARRAY_SIZE(links); i++) {
+		struct nlattr *nl_link = nla_nest_start(msg, i + 1);
+
+		if (!nl_link ||
+		    nla_put_u8(msg, IWL_MVM_VENDOR_TCM_LINK_ID, i) ||
+		    nla_put_u8(msg, IWL_MVM_VENDOR_TCM_LINK_LOAD,
+			       links[i].load) ||
+		    nla_put(msg, IWL_MVM_VENDOR_TCM_LINK_AIRTIME,
+			    sizeof(links[i].airtime), links[i].airtime) ||
+		    nla_put(msg, IWL_MVM_VENDOR_TCM_LINK_PKT_RATE,
+			    sizeof(links[i].pkt_rate), links[i].pkt_rate))
+			goto nla_put_failure;
+
+		nla_nest_end(msg, nl_link);
+	}
+
+	nla_nest_end(msg, nl_links);
+	cfg80211_vendor_event(msg, GFP_KERNEL);
+	return;
+
+ nla_put_failure:
+	kfree_skb(msg);
+}
@@ -14,6 +14,7 @@
 #include <linux/pci.h>
 #include <linux/timer.h>
 #include <linux/cpu.h>
+#include <linux/u64_stats_sync.h>
 
 #include "iwl-fh.h"
 #include "iwl-csr.h"
@@ -32,6 +33,8 @@
 #define RX_POST_REQ_ALLOC 2
 #define RX_CLAIM_REQ_ALLOC 8
 #define RX_PENDING_WATERMARK 16
+/* default number of RBDs to restock before updating the write pointer */
+#define RX_RESTOCK_BATCH_DEF 32
 #define FIRST_RX_QUEUE 512
 
 struct iwl_host_cmd;
@@ -58,6 +61,19 @@ struct iwl_rx_mem_buffer {
 	bool invalid;
 };
 
+/* max number of pages given to the stack that a queue keeps for reuse */
+#define IWL_RX_RECYCLE_RING_SIZE	256
+
+/**
+ * struct iwl_rx_recycle_page - RX page kept for reuse
+ * @page: the page, the driver still holds one reference
+ * @page_dma: bus address of the page, the mapping is kept for reuse
+ */
+struct iwl_rx_recycle_page {
+	struct page *page;
+	dma_addr_t page_dma;
+};
+
 /* interrupt statistics */
 struct isr_statistics {
 	u32 hw;
@@ -113,6 +129,24 @@ struct iwl_rx_completion_desc_bz {
 	u8 reserved[1];
 } __packed;
 
+/**
+ * struct iwl_rxq_stats - per-CPU Rx queue statistics
+ * @polls: number of times the queue was polled
+ * @rbs: number of RBs handled
+ * @budget_exhausted: number of polls that used up the whole NAPI budget
+ * @emergency: number of times the queue entered the emergency path
+ * @page_steals: number of RBs whose page was handed to the stack
+ * @syncp: synchronization for the 64-bit counters
+ */
+struct iwl_rxq_stats {
+	u64 polls;
+	u64 rbs;
+	u64 budget_exhausted;
+	u64 emergency;
+	u64 page_steals;
+	struct u64_stats_sync syncp;
+};
+
 /**
  * struct iwl_rxq - Rx queue
  * @id: queue index
@@ -140,6 +174,14 @@ struct iwl_rx_completion_desc_bz {
  *	the fragmented flag, so the next one is still another fragment
  * @napi: NAPI struct for this queue
  * @queue_size: size of this queue
+ * @recycle: ring of pages handed to the stack that are still mapped, and
+ *	can be reused once the stack released them (only if
+ *	&iwl_trans_pcie.rx_page_recycle is set)
+ * @recycle_head: index of the oldest page in @recycle
+ * @recycle_count: number of pages in @recycle
+ * @doorbells: number of write pointer updates
+ * @doorbell_rbds: number of RBDs given to the device by those updates
+ * @stats: per-CPU statistics, updated once per poll
  *
  * NOTE:  rx_free and rx_used are used as a FIFO for iwl_rx_mem_buffers
  */
@@ -163,6 +205,27 @@ struct iwl_rxq {
 	spinlock_t lock;
 	struct napi_struct napi;
 	struct iwl_rx_mem_buffer *queue[RX_QUEUE_SIZE];
+	struct iwl_rx_recycle_page *recycle;
+	u16 recycle_head, recycle_count;
+	u32 doorbells;
+	u64 doorbell_rbds;
+	struct iwl_rxq_stats __percpu *stats;
+};
+
+/**
+ * enum iwl_pcie_rx_affinity - RX queue IRQ affinity policy
+ * @IWL_PCIE_RX_AFFINITY_SPREAD: spread the queues over all online CPUs
+ * @IWL_PCIE_RX_AFFINITY_NUMA: spread the queues over the online CPUs of
+ *	the device's NUMA node
+ * @IWL_PCIE_RX_AFFINITY_HOUSEKEEPING: spread the queues over the CPUs
+ *	that aren't isolated from managed interrupts
+ * @IWL_PCIE_RX_AFFINITY_CPUS: spread the queues over an explicit CPU list
+ */
+enum iwl_pcie_rx_affinity {
+	IWL_PCIE_RX_AFFINITY_SPREAD,
+	IWL_PCIE_RX_AFFINITY_NUMA,
+	IWL_PCIE_RX_AFFINITY_HOUSEKEEPING,
+	IWL_PCIE_RX_AFFINITY_CPUS,
 };
 
 /**
@@ -206,6 +269,13 @@ static inline u16 iwl_get_closed_rb_stts(struct iwl_trans *trans,
 	}
 }
 
+int iwl_pcie_rxq_stats(struct iwl_trans *trans, int queue,
+		       struct iwl_trans_rxq_stats *stats);
+
+#if IS_ENABLED(CPTCFG_IWLWIFI_KUNIT_TESTS)
+bool iwl_pcie_rxq_doorbell_needed(const struct iwl_rxq *rxq, u32 batch);
+#endif
+
 #ifdef CPTCFG_IWLWIFI_DEBUGFS
 /**
  * enum iwl_fw_mon_dbgfs_state - the different states of the monitor_data
@@ -292,6 +362,8 @@ enum iwl_pcie_imr_status {
  * @rx_pool: initial pool of iwl_rx_mem_buffer for all the queues
  * @global_table: table mapping received VID from hw to rxb
  * @rba: allocator for RX replenishing
+ * @rx_restock_batch: number of restocked RBDs to accumulate before updating
+ *	the RX write pointer, unless the device is running low on RBDs
  * @ctxt_info: context information for FW self init
  * @ctxt_info_gen3: context information for gen3 devices
  * @prph_info: prph info for self init
@@ -312,11 +384,15 @@ enum iwl_pcie_imr_status {
  * @hw_base: pci hardware address support
  * @ucode_write_complete: indicates that the ucode has been copied.
  * @ucode_write_waitq: wait queue for uCode load
+ * @fw_load_bufs: bounce buffers for loading the uCode sections, one is
+ *	filled while the device reads the other
  * @cmd_queue - command queue number
  * @rx_buf_size: Rx buffer size
  * @scd_set_active: should the transport configure the SCD for HCMD queue
  * @rx_page_order: page order for receive buffer size
  * @rx_buf_bytes: RX buffer (RB) size in bytes
+ * @rx_page_recycle: keep RB pages mapped, and reuse pages given to the stack
+ *	once they're released instead of allocating and mapping new ones
  * @reg_lock: protect hw register access
  * @mutex: to protect stop_device / start_fw / start_hw
  * @fw_mon_data: fw continuous recording data
@@ -359,6 +435,8 @@ enum iwl_pcie_imr_status {
  *	(firmware workaround)
  * @n_no_reclaim_cmds: number of special commands not using reclaim flow
  * @affinity_mask: IRQ affinity mask for each RX queue
+ * @rx_affinity: RX queue IRQ affinity policy, see &enum iwl_pcie_rx_affinity
+ * @rx_affinity_cpus: CPUs to use for %IWL_PCIE_RX_AFFINITY_CPUS
  * @debug_rfkill: RF-kill debugging state, -1 for unset, 0/1 for radio
  *	enable/disable
  * @fw_reset_handshake: indicates FW reset handshake is needed
@@ -416,6 +494,7 @@ struct iwl_trans_pcie {
 	bool ucode_write_complete;
 	bool sx_complete;
 	wait_queue_head_t ucode_write_waitq;
+	struct iwl_dma_ptr fw_load_bufs[2];
 	wait_queue_head_t sx_waitq;
 
 	u8 n_no_reclaim_cmds;
@@ -427,6 +506,8 @@ struct iwl_trans_pcie {
 	bool pcie_dbg_dumped_once;
 	u32 rx_page_order;
 	u32 rx_buf_bytes;
+	bool rx_page_recycle;
+	u32 rx_restock_batch;
 	u32 supported_dma_mask;
 
 	/* allocator lock for the two values below */
@@ -452,6 +533,8 @@ struct iwl_trans_pcie {
 	u32 fh_mask;
 	u32 hw_mask;
 	cpumask_t affinity_mask[IWL_MAX_RX_HW_QUEUES];
+	enum iwl_pcie_rx_affinity rx_affinity;
+	cpumask_t rx_affinity_cpus;
 	bool in_rescan;
 
 	void *base_rb_stts;
@@ -109,8 +109,15 @@
  * allocator.rbd_allocated -> rxq.rx_free -> rxq.queue
  * Page not Stolen:
  * rxq.queue -> rxq.rx_free -> rxq.queue
+ * Page Stolen, with rx_page_recycle and a released page in rxq.recycle:
+ * rxq.queue -> rxq.rx_free -> rxq.queue
  * ...
  *
+ * With rx_page_recycle the RB pages stay DMA mapped while handled, and the
+ * pages stolen by the op mode are kept (with their mapping) in rxq.recycle.
+ * Once the stack released the oldest of them, it's attached to the RBD that
+ * just lost its page instead of going through the allocator.
+ *
  */
 
 /*
@@ -189,6 +196,9 @@ static void iwl_pcie_rxq_inc_wr_ptr(struct iwl_trans *trans,
 		}
 	}
 
+	rxq->doorbells++;
+	rxq->doorbell_rbds += (round_down(rxq->write, 8) - rxq->write_actual) &
+			      (rxq->queue_size - 1);
 	rxq->write_actual = round_down(rxq->write, 8);
 	if (!trans->trans_cfg->mq_rx_supported)
 		iwl_write32(trans, FH_RSCSR_CHNL0_WPTR, rxq->write_actual);
@@ -200,6 +210,29 @@ static void iwl_pcie_rxq_inc_wr_ptr(struct iwl_trans *trans,
 			    rxq->write_actual);
 }
 
+/*
+ * iwl_pcie_rxq_doorbell_needed - check if the write pointer should be updated
+ *
+ * Updating the write pointer is an expensive MMIO access, so accumulate
+ * restocked RBDs until there are at least @batch of them, unless the
+ * device is running low on empty RBDs - in that case don't hold them back.
+ */
+VISIBLE_IF_IWLWIFI_KUNIT
+bool iwl_pcie_rxq_doorbell_needed(const struct iwl_rxq *rxq, u32 batch)
+{
+	u32 mask = rxq->queue_size - 1;
+	/* the device's write pointer can only be moved in multiples of 8 */
+	u32 pending = (round_down(rxq->write, 8) - rxq->write_actual) & mask;
+	/* RBDs the device has that we didn't get back yet */
+	u32 posted = (rxq->write_actual - rxq->read) & mask;
+
+	if (!pending)
+		return false;
+
+	return pending >= batch || posted <= rxq->queue_size / 4;
+}
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_pcie_rxq_doorbell_needed);
+
 static void iwl_pcie_rxq_check_wrptr(struct iwl_trans *trans)
 {
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
@@ -275,10 +308,11 @@ static void iwl_pcie_rxmq_restock(struct iwl_trans *trans,
 	spin_unlock_bh(&rxq->lock);
 
 	/*
-	 * If we've added more space for the firmware to place data, tell it.
+	 * If we've added enough space for the firmware to place data, tell it.
 	 * Increment device's write pointer in multiples of 8.
 	 */
-	if (rxq->write_actual != (rxq->write & ~0x7)) {
+	if (iwl_pcie_rxq_doorbell_needed(rxq,
+					 READ_ONCE(trans_pcie->rx_restock_batch))) {
 		spin_lock_bh(&rxq->lock);
 		iwl_pcie_rxq_inc_wr_ptr(trans, rxq);
 		spin_unlock_bh(&rxq->lock);
@@ -291,6 +325,7 @@ static void iwl_pcie_rxmq_restock(struct iwl_trans *trans,
 static void iwl_pcie_rxsq_restock(struct iwl_trans *trans,
 				  struct iwl_rxq *rxq)
 {
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 	struct iwl_rx_mem_buffer *rxb;
 
 	/*
@@ -325,9 +360,10 @@ static void iwl_pcie_rxsq_restock(struct iwl_trans *trans,
 	}
 	spin_unlock_bh(&rxq->lock);
 
-	/* If we've added more space for the firmware to place data, tell it.
+	/* If we've added enough space for the firmware to place data, tell it.
 	 * Increment device's write pointer in multiples of 8. */
-	if (rxq->write_actual != (rxq->write & ~0x7)) {
+	if (iwl_pcie_rxq_doorbell_needed(rxq,
+					 READ_ONCE(trans_pcie->rx_restock_batch))) {
 		spin_lock_bh(&rxq->lock);
 		iwl_pcie_rxq_inc_wr_ptr(trans, rxq);
 		spin_unlock_bh(&rxq->lock);
@@ -370,6 +406,13 @@ static struct page *iwl_pcie_rx_alloc_page(struct iwl_trans *trans,
 	if (trans_pcie->rx_page_order > 0)
 		gfp_mask |= __GFP_COMP;
 
+	/*
+	 * With page recycling each RB owns its page(s), so we can tell from
+	 * the page's refcount if the stack is still using it.
+	 */
+	if (trans_pcie->rx_page_recycle)
+		goto alloc;
+
 	if (trans_pcie->alloc_page) {
 		spin_lock_bh(&trans_pcie->alloc_page_lock);
 		/* recheck */
@@ -387,6 +430,7 @@ static struct page *iwl_pcie_rx_alloc_page(struct iwl_trans *trans,
 		spin_unlock_bh(&trans_pcie->alloc_page_lock);
 	}
 
+alloc:
 	/* Alloc a new receive buffer */
 	page = alloc_pages(gfp_mask, trans_pcie->rx_page_order);
 	if (!page) {
@@ -403,7 +447,7 @@ static struct page *iwl_pcie_rx_alloc_page(struct iwl_trans *trans,
 		return NULL;
 	}
 
-	if (2 * rbsize <= allocsize) {
+	if (2 * rbsize <= allocsize && !trans_pcie->rx_page_recycle) {
 		spin_lock_bh(&trans_pcie->alloc_page_lock);
 		if (!trans_pcie->alloc_page) {
 			get_page(page);
@@ -485,11 +529,110 @@ void iwl_pcie_rxq_alloc_rbs(struct iwl_trans *trans, gfp_t priority,
 	}
 }
 
+static void iwl_pcie_rx_recycle_release(struct iwl_trans *trans,
+					struct iwl_rx_recycle_page *entry)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+
+	/* the CPU already owns the data since the page was handled */
+	dma_unmap_page_attrs(trans->dev, entry->page_dma,
+			     trans_pcie->rx_buf_bytes, DMA_FROM_DEVICE,
+			     DMA_ATTR_SKIP_CPU_SYNC);
+	__free_pages(entry->page, trans_pcie->rx_page_order);
+	entry->page = NULL;
+}
+
+static void iwl_pcie_rx_recycle_purge(struct iwl_trans *trans,
+				      struct iwl_rxq *rxq)
+{
+	while (rxq->recycle_count) {
+		iwl_pcie_rx_recycle_release(trans,
+					    &rxq->recycle[rxq->recycle_head]);
+		rxq->recycle_head = (rxq->recycle_head + 1) &
+				    (IWL_RX_RECYCLE_RING_SIZE - 1);
+		rxq->recycle_count--;
+	}
+	rxq->recycle_head = 0;
+}
+
+/*
+ * iwl_pcie_rx_recycle_put - keep a stolen page for reuse
+ *
+ * The op mode took its own reference(s) to the page. Keep ours along with
+ * the DMA mapping, the page can be reused once all the others are dropped.
+ * If the ring is full, give up on the oldest page.
+ */
+static void iwl_pcie_rx_recycle_put(struct iwl_trans *trans,
+				    struct iwl_rxq *rxq,
+				    struct iwl_rx_mem_buffer *rxb)
+{
+	struct iwl_rx_recycle_page *entry;
+
+	BUILD_BUG_ON(!is_power_of_2(IWL_RX_RECYCLE_RING_SIZE));
+
+	if (rxq->recycle_count == IWL_RX_RECYCLE_RING_SIZE) {
+		iwl_pcie_rx_recycle_release(trans,
+					    &rxq->recycle[rxq->recycle_head]);
+		rxq->recycle_head = (rxq->recycle_head + 1) &
+				    (IWL_RX_RECYCLE_RING_SIZE - 1);
+		rxq->recycle_count--;
+	}
+
+	entry = &rxq->recycle[(rxq->recycle_head + rxq->recycle_count) &
+			      (IWL_RX_RECYCLE_RING_SIZE - 1)];
+	entry->page = rxb->page;
+	entry->page_dma = rxb->page_dma;
+	rxq->recycle_count++;
+
+	rxb->page = NULL;
+}
+
+/*
+ * iwl_pcie_rx_recycle_get - attach a released page to an RBD
+ *
+ * Only the oldest page is checked, if that one is still in use by the
+ * stack the newer ones most likely are as well.
+ */
+static bool iwl_pcie_rx_recycle_get(struct iwl_trans *trans,
+				    struct iwl_rxq *rxq,
+				    struct iwl_rx_mem_buffer *rxb)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_rx_recycle_page *entry;
+
+	if (!rxq->recycle_count)
+		return false;
+
+	entry = &rxq->recycle[rxq->recycle_head];
+	if (page_ref_count(entry->page) != 1)
+		return false;
+
+	rxb->page = entry->page;
+	rxb->page_dma = entry->page_dma;
+	rxb->offset = 0;
+	entry->page = NULL;
+	rxq->recycle_head = (rxq->recycle_head + 1) &
+			    (IWL_RX_RECYCLE_RING_SIZE - 1);
+	rxq->recycle_count--;
+
+	dma_sync_single_for_device(trans->dev, rxb->page_dma,
+				   trans_pcie->rx_buf_bytes, DMA_FROM_DEVICE);
+
+	return true;
+}
+
 void iwl_pcie_free_rbs_pool(struct iwl_trans *trans)
 {
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 	int i;
 
+	for (i = 0; trans_pcie->rxq && i < trans->num_rx_queues; i++) {
+		struct iwl_rxq *rxq = &trans_pcie->rxq[i];
+
+		if (rxq->recycle)
+			iwl_pcie_rx_recycle_purge(trans, rxq);
+	}
+
 	if (!trans_pcie->rx_pool)
 		return;
 
@@ -810,10 +953,31 @@ static int iwl_pcie_rx_alloc(struct iwl_trans *trans)
 		ret = iwl_pcie_alloc_rxq_dma(trans, rxq);
 		if (ret)
 			goto err;
+
+		rxq->stats = netdev_alloc_pcpu_stats(struct iwl_rxq_stats);
+		if (!rxq->stats) {
+			ret = -ENOMEM;
+			goto err;
+		}
+
+		if (!trans_pcie->rx_page_recycle)
+			continue;
+
+		rxq->recycle = kcalloc(IWL_RX_RECYCLE_RING_SIZE,
+				       sizeof(*rxq->recycle), GFP_KERNEL);
+		if (!rxq->recycle) {
+			ret = -ENOMEM;
+			goto err;
+		}
 	}
 	return 0;
 
 err:
+	for (i = 0; trans_pcie->rxq && i < trans->num_rx_queues; i++) {
+		kfree(trans_pcie->rxq[i].recycle);
+		free_percpu(trans_pcie->rxq[i].stats);
+	}
+
 	if (trans_pcie->base_rb_stts) {
 		dma_free_coherent(trans->dev,
 				  rb_stts_size * trans->num_rx_queues,
@@ -1227,6 +1391,8 @@ void iwl_pcie_rx_free(struct iwl_trans *trans)
 		struct iwl_rxq *rxq = &trans_pcie->rxq[i];
 
 		iwl_pcie_free_rxq_dma(trans, rxq);
+		kfree(rxq->recycle);
+		free_percpu(rxq->stats);
 
 		if (rxq->napi.poll) {
 			napi_disable(&rxq->napi);
@@ -1287,7 +1453,56 @@ static void iwl_pcie_rx_reuse_rbd(struct iwl_trans *trans,
 	}
 }
 
-static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
+/*
+ * iwl_pcie_rx_handle_rb_recycle - return an RB with page recycling
+ *
+ * The page is still mapped. If it wasn't stolen, just give it back to the
+ * device. Otherwise keep it for later reuse and try to attach a page that
+ * the stack has released in the meantime.
+ */
+static void iwl_pcie_rx_handle_rb_recycle(struct iwl_trans *trans,
+					  struct iwl_rxq *rxq,
+					  struct iwl_rx_mem_buffer *rxb,
+					  bool page_stolen, bool emergency)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+
+	if (!page_stolen) {
+		dma_sync_single_for_device(trans->dev, rxb->page_dma,
+					   trans_pcie->rx_buf_bytes,
+					   DMA_FROM_DEVICE);
+		list_add_tail(&rxb->list, &rxq->rx_free);
+		rxq->free_count++;
+		return;
+	}
+
+	if (likely(!page_is_pfmemalloc(rxb->page))) {
+		iwl_pcie_rx_recycle_put(trans, rxq, rxb);
+	} else {
+		/* emergency reserve pages must go back to the page allocator */
+		struct iwl_rx_recycle_page entry = {
+			.page = rxb->page,
+			.page_dma = rxb->page_dma,
+		};
+
+		iwl_pcie_rx_recycle_release(trans, &entry);
+		rxb->page = NULL;
+	}
+
+	if (iwl_pcie_rx_recycle_get(trans, rxq, rxb)) {
+		list_add_tail(&rxb->list, &rxq->rx_free);
+		rxq->free_count++;
+	} else {
+		iwl_pcie_rx_reuse_rbd(trans, rxb, rxq, emergency);
+	}
+}
+
+/*
+ * iwl_pcie_rx_handle_rb - handle a single RB
+ *
+ * Returns true if the page was passed up and is no longer ours.
+ */
+static bool iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 				  struct iwl_rxq *rxq,
 				  struct iwl_rx_mem_buffer *rxb,
 				  bool emergency,
@@ -1300,9 +1515,14 @@ static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 	u32 offset = 0;
 
 	if (WARN_ON(!rxb))
-		return;
+		return false;
 
-	dma_unmap_page(trans->dev, rxb->page_dma, max_len, DMA_FROM_DEVICE);
+	if (trans_pcie->rx_page_recycle)
+		dma_sync_single_for_cpu(trans->dev, rxb->page_dma, max_len,
+					DMA_FROM_DEVICE);
+	else
+		dma_unmap_page(trans->dev, rxb->page_dma, max_len,
+			       DMA_FROM_DEVICE);
 
 	while (offset + sizeof(u32) + sizeof(struct iwl_cmd_header) < max_len) {
 		struct iwl_rx_packet *pkt;
@@ -1405,6 +1625,12 @@ static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 			break;
 	}
 
+	if (trans_pcie->rx_page_recycle) {
+		iwl_pcie_rx_handle_rb_recycle(trans, rxq, rxb, page_stolen,
+					      emergency);
+		return page_stolen;
+	}
+
 	/* page was stolen from us -- free our reference */
 	if (page_stolen) {
 		__free_pages(rxb->page, trans_pcie->rx_page_order);
@@ -1434,6 +1660,8 @@ static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 		}
 	} else
 		iwl_pcie_rx_reuse_rbd(trans, rxb, rxq, emergency);
+
+	return page_stolen;
 }
 
 static struct iwl_rx_mem_buffer *iwl_pcie_get_rxb(struct iwl_trans *trans,
@@ -1495,7 +1723,9 @@ static int iwl_pcie_rx_handle(struct iwl_trans *trans, int queue, int budget)
 {
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 	struct iwl_rxq *rxq;
+	struct iwl_rxq_stats *stats;
 	u32 r, i, count = 0, handled = 0;
+	u32 rbs = 0, emergencies = 0, page_steals = 0;
 	bool emergency = false;
 
 	if (WARN_ON_ONCE(!trans_pcie->rxq || !trans_pcie->rxq[queue].bd))
@@ -1530,6 +1760,7 @@ restart:
 			     !emergency)) {
 			iwl_pcie_rx_move_to_allocator(rxq, rba);
 			emergency = true;
+			emergencies++;
 			IWL_DEBUG_TPT(trans,
 				      "RX path is in emergency. Pending allocations %d\n",
 				      rb_pending_alloc);
@@ -1557,10 +1788,12 @@ restart:
 			 */
 			list_add_tail(&rxb->list, &rxq->rx_free);
 			rxq->free_count++;
-		} else {
-			iwl_pcie_rx_handle_rb(trans, rxq, rxb, emergency, i);
+		} else if (iwl_pcie_rx_handle_rb(trans, rxq, rxb, emergency,
+						 i)) {
+			page_steals++;
 		}
 
+		rbs++;
 		i = (i + 1) & (rxq->queue_size - 1);
 
 		/*
@@ -1617,9 +1850,63 @@ out:
 
 	iwl_pcie_rxq_restock(trans, rxq);
 
+	if (rbs)
+		iwl_op_mode_rx_done(trans->op_mode, &rxq->napi, rxq->id);
+
+	stats = this_cpu_ptr(rxq->stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->polls++;
+	stats->rbs += rbs;
+	stats->emergency += emergencies;
+	stats->page_steals += page_steals;
+	if (handled >= budget)
+		stats->budget_exhausted++;
+	u64_stats_update_end(&stats->syncp);
+
 	return handled;
 }
 
+int iwl_pcie_rxq_stats(struct iwl_trans *trans, int queue,
+		       struct iwl_trans_rxq_stats *stats)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_rxq *rxq;
+	int cpu;
+
+	if (queue >= trans->num_rx_queues || !trans_pcie->rxq)
+		return -EINVAL;
+
+	rxq = &trans_pcie->rxq[queue];
+	memset(stats, 0, sizeof(*stats));
+
+	for_each_possible_cpu(cpu) {
+		const struct iwl_rxq_stats *pcpu = per_cpu_ptr(rxq->stats, cpu);
+		u64 polls, rbs, budget_exhausted, emergency, page_steals;
+		unsigned int start;
+
+		do {
+			start = u64_stats_fetch_begin(&pcpu->syncp);
+			polls = pcpu->polls;
+			rbs = pcpu->rbs;
+			budget_exhausted = pcpu->budget_exhausted;
+			emergency = pcpu->emergency;
+			page_steals = pcpu->page_steals;
+		} while (u64_stats_fetch_retry(&pcpu->syncp, start));
+
+		stats->polls += polls;
+		stats->rbs += rbs;
+		stats->budget_exhausted += budget_exhausted;
+		stats->emergency += emergency;
+		stats->page_steals += page_steals;
+	}
+
+	/* RBs given to the device that it didn't return yet */
+	stats->rbs_in_use = (READ_ONCE(rxq->write_actual) -
+			     READ_ONCE(rxq->read)) & (rxq->queue_size - 1);
+
+	return 0;
+}
+
 static struct iwl_trans_pcie *iwl_pcie_get_trans_pcie(struct msix_entry *entry)
 {
 	u8 queue = entry->entry;
@@ -8,6 +8,7 @@
 #include <linux/interrupt.h>
 #include <linux/debugfs.h>
 #include <linux/sched.h>
+#include <linux/sched/isolation.h>
 #include <linux/bitops.h>
 #include <linux/gfp.h>
 #include <linux/vmalloc.h>
@@ -691,12 +692,11 @@ static void iwl_pcie_load_firmware_chunk_fh(struct iwl_trans *trans,
 		    FH_TCSR_TX_CONFIG_REG_VAL_CIRQ_HOST_ENDTFD);
 }
 
-static int iwl_pcie_load_firmware_chunk(struct iwl_trans *trans,
-					u32 dst_addr, dma_addr_t phy_addr,
-					u32 byte_cnt)
+static int iwl_pcie_start_firmware_chunk(struct iwl_trans *trans,
+					 u32 dst_addr, dma_addr_t phy_addr,
+					 u32 byte_cnt)
 {
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
-	int ret;
 
 	trans_pcie->ucode_write_complete = false;
 
@@ -707,6 +707,14 @@ static int iwl_pcie_load_firmware_chunk(struct iwl_trans *trans,
 					byte_cnt);
 	iwl_trans_release_nic_access(trans);
 
+	return 0;
+}
+
+static int iwl_pcie_wait_firmware_chunk(struct iwl_trans *trans)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	int ret;
+
 	ret = wait_event_timeout(trans_pcie->ucode_write_waitq,
 				 trans_pcie->ucode_write_complete, 5 * HZ);
 	if (!ret) {
@@ -718,30 +726,73 @@ static int iwl_pcie_load_firmware_chunk(struct iwl_trans *trans,
 	return 0;
 }
 
+static void iwl_pcie_free_fw_load_bufs(struct iwl_trans *trans)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(trans_pcie->fw_load_bufs); i++)
+		iwl_pcie_free_dma_ptr(trans, &trans_pcie->fw_load_bufs[i]);
+}
+
+/*
+ * The bounce buffers for loading the firmware are allocated on the first
+ * load and kept until the transport is freed, so that restarting the
+ * firmware after an error doesn't need to allocate them again.
+ */
+static int iwl_pcie_alloc_fw_load_bufs(struct iwl_trans *trans)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	size_t size = FH_MEM_TB_MAX_LENGTH;
+	int i;
+
+	if (trans_pcie->fw_load_bufs[0].addr)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(trans_pcie->fw_load_bufs); i++) {
+		struct iwl_dma_ptr *buf = &trans_pcie->fw_load_bufs[i];
+
+		buf->addr = dma_alloc_coherent(trans->dev, size, &buf->dma,
+					       GFP_KERNEL | __GFP_NOWARN);
+		if (!buf->addr && size > PAGE_SIZE) {
+			IWL_DEBUG_INFO(trans,
+				       "Falling back to small chunks of DMA\n");
+			iwl_pcie_free_fw_load_bufs(trans);
+			size = PAGE_SIZE;
+			i = -1;
+			continue;
+		}
+		if (!buf->addr) {
+			iwl_pcie_free_fw_load_bufs(trans);
+			return -ENOMEM;
+		}
+		buf->size = size;
+	}
+
+	return 0;
+}
+
 static int iwl_pcie_load_section(struct iwl_trans *trans, u8 section_num,
 			    const struct fw_desc *section)
 {
-	u8 *v_addr;
-	dma_addr_t p_addr;
-	u32 offset, chunk_sz = min_t(u32, FH_MEM_TB_MAX_LENGTH, section->len);
-	int ret = 0;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_dma_ptr *bufs = trans_pcie->fw_load_bufs;
+	u32 offset, chunk_sz;
+	int ret, cur = 0;
 
 	IWL_DEBUG_FW(trans, "[%d] uCode section being loaded...\n",
 		     section_num);
 
-	v_addr = dma_alloc_coherent(trans->dev, chunk_sz, &p_addr,
-				    GFP_KERNEL | __GFP_NOWARN);
-	if (!v_addr) {
-		IWL_DEBUG_INFO(trans, "Falling back to small chunks of DMA\n");
-		chunk_sz = PAGE_SIZE;
-		v_addr = dma_alloc_coherent(trans->dev, chunk_sz,
-					    &p_addr, GFP_KERNEL);
-		if (!v_addr)
-			return -ENOMEM;
-	}
+	ret = iwl_pcie_alloc_fw_load_bufs(trans);
+	if (ret)
+		return ret;
+
+	chunk_sz = bufs[0].size;
+	memcpy(bufs[cur].addr, section->data,
+	       min_t(u32, chunk_sz, section->len));
 
 	for (offset = 0; offset < section->len; offset += chunk_sz) {
-		u32 copy_size, dst_addr;
+		u32 copy_size, dst_addr, next = offset + chunk_sz;
 		bool extended_addr = false;
 
 		copy_size = min_t(u32, chunk_sz, section->len - offset);
@@ -755,9 +806,17 @@ static int iwl_pcie_load_section(struct iwl_trans *trans, u8 section_num,
 			iwl_set_bits_prph(trans, LMPM_CHICK,
 					  LMPM_CHICK_EXTENDED_ADDR_SPACE);
 
-		memcpy(v_addr, (const u8 *)section->data + offset, copy_size);
-		ret = iwl_pcie_load_firmware_chunk(trans, dst_addr, p_addr,
-						   copy_size);
+		ret = iwl_pcie_start_firmware_chunk(trans, dst_addr,
+						    bufs[cur].dma, copy_size);
+
+		/* copy the next chunk while the device reads this one */
+		if (!ret && next < section->len)
+			memcpy(bufs[!cur].addr,
+			       (const u8 *)section->data + next,
+			       min_t(u32, chunk_sz, section->len - next));
+
+		if (!ret)
+			ret = iwl_pcie_wait_firmware_chunk(trans);
 
 		if (extended_addr)
 			iwl_clear_bits_prph(trans, LMPM_CHICK,
@@ -769,9 +828,10 @@ static int iwl_pcie_load_section(struct iwl_trans *trans, u8 section_num,
 				section_num);
 			break;
 		}
+
+		cur = !cur;
 	}
 
-	dma_free_coherent(trans->dev, chunk_sz, v_addr, p_addr);
 	return ret;
 }
 
@@ -1764,21 +1824,93 @@ enable_msi:
 	}
 }
 
+static const char * const iwl_pcie_rx_affinity_names[] = {
+	[IWL_PCIE_RX_AFFINITY_SPREAD] = "spread",
+	[IWL_PCIE_RX_AFFINITY_NUMA] = "numa",
+	[IWL_PCIE_RX_AFFINITY_HOUSEKEEPING] = "housekeeping",
+};
+
+/*
+ * iwl_pcie_rx_affinity_parse - parse an RX affinity policy
+ *
+ * The policy is either one of iwl_pcie_rx_affinity_names or a CPU list
+ * in the usual "0-3,8" format, which is then stored in @cpus.
+ */
+static int iwl_pcie_rx_affinity_parse(const char *str,
+				      enum iwl_pcie_rx_affinity *policy,
+				      struct cpumask *cpus)
+{
+	int i, ret;
+
+	if (!str || !*str) {
+		*policy = IWL_PCIE_RX_AFFINITY_SPREAD;
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(iwl_pcie_rx_affinity_names); i++) {
+		if (iwl_pcie_rx_affinity_names[i] &&
+		    sysfs_streq(str, iwl_pcie_rx_affinity_names[i])) {
+			*policy = i;
+			return 0;
+		}
+	}
+
+	ret = cpulist_parse(str, cpus);
+	if (ret)
+		return ret;
+	if (cpumask_empty(cpus))
+		return -EINVAL;
+
+	*policy = IWL_PCIE_RX_AFFINITY_CPUS;
+	return 0;
+}
+
+/*
+ * iwl_pcie_irq_set_affinity - spread the RSS queue IRQs over the CPUs
+ *
+ * May be called again at runtime after the policy changed, since the RX
+ * path runs in the threaded IRQ handler and NAPI, both follow the IRQ to
+ * the new CPU without any firmware involvement.
+ */
 static void iwl_pcie_irq_set_affinity(struct iwl_trans *trans)
 {
 #if defined(CONFIG_SMP)
-	int iter_rx_q, i, ret, cpu, offset;
+	int iter_rx_q, i, ret, cpu = -1;
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	const struct cpumask *policy_mask = cpu_online_mask;
+	cpumask_var_t cpus;
+
+	if (!zalloc_cpumask_var(&cpus, GFP_KERNEL))
+		return;
+
+	switch (trans_pcie->rx_affinity) {
+	case IWL_PCIE_RX_AFFINITY_NUMA:
+		if (dev_to_node(trans->dev) != NUMA_NO_NODE)
+			policy_mask = cpumask_of_node(dev_to_node(trans->dev));
+		break;
+	case IWL_PCIE_RX_AFFINITY_HOUSEKEEPING:
+		policy_mask = housekeeping_cpumask(HK_TYPE_MANAGED_IRQ);
+		break;
+	case IWL_PCIE_RX_AFFINITY_CPUS:
+		policy_mask = &trans_pcie->rx_affinity_cpus;
+		break;
+	default:
+		break;
+	}
+
+	if (!cpumask_and(cpus, policy_mask, cpu_online_mask)) {
+		IWL_WARN(trans,
+			 "No online CPU matches the RX affinity policy, using all\n");
+		cpumask_copy(cpus, cpu_online_mask);
+	}
 
 	i = trans_pcie->shared_vec_mask & IWL_SHARED_IRQ_FIRST_RSS ? 0 : 1;
 	iter_rx_q = trans_pcie->trans->num_rx_queues - 1 + i;
-	offset = 1 + i;
 	for (; i < iter_rx_q ; i++) {
-		/*
-		 * Get the cpu prior to the place to search
-		 * (i.e. return will be > i - 1).
-		 */
-		cpu = cpumask_next(i - offset, cpu_online_mask);
+		cpu = cpumask_next(cpu, cpus);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpus);
+		cpumask_clear(&trans_pcie->affinity_mask[i]);
 		cpumask_set_cpu(cpu, &trans_pcie->affinity_mask[i]);
 		ret = irq_set_affinity_hint(trans_pcie->msix_entries[i].vector,
 					    &trans_pcie->affinity_mask[i]);
@@ -1787,6 +1919,8 @@ static void iwl_pcie_irq_set_affinity(struct iwl_trans *trans)
 				"Failed to set affinity mask for IRQ %d\n",
 				trans_pcie->msix_entries[i].vector);
 	}
+
+	free_cpumask_var(cpus);
 #endif
 }
 
@@ -1820,6 +1954,15 @@ static int iwl_pcie_init_msix_handler(struct pci_dev *pdev,
 			return ret;
 		}
 	}
+
+	if (iwl_pcie_rx_affinity_parse(iwlwifi_mod_params.rx_affinity,
+				       &trans_pcie->rx_affinity,
+				       &trans_pcie->rx_affinity_cpus)) {
+		IWL_ERR(trans_pcie->trans,
+			"Invalid rx_affinity '%s', spreading over all CPUs\n",
+			iwlwifi_mod_params.rx_affinity);
+		trans_pcie->rx_affinity = IWL_PCIE_RX_AFFINITY_SPREAD;
+	}
 	iwl_pcie_irq_set_affinity(trans_pcie->trans);
 
 	return 0;
@@ -2027,6 +2170,7 @@ static void iwl_trans_pcie_configure(struct iwl_trans *trans,
 		iwl_trans_get_rb_size_order(trans_pcie->rx_buf_size);
 	trans_pcie->rx_buf_bytes =
 		iwl_trans_get_rb_size(trans_pcie->rx_buf_size);
+	trans_pcie->rx_page_recycle = iwlwifi_mod_params.rx_page_recycle;
 	trans_pcie->supported_dma_mask = DMA_BIT_MASK(12);
 	if (trans->trans_cfg->device_family >= IWL_DEVICE_FAMILY_AX210)
 		trans_pcie->supported_dma_mask = DMA_BIT_MASK(11);
@@ -2128,6 +2272,7 @@ void iwl_trans_pcie_free(struct iwl_trans *trans)
 	iwl_pcie_free_invalid_tx_cmd(trans);
 
 	iwl_pcie_free_fw_monitor(trans);
+	iwl_pcie_free_fw_load_bufs(trans);
 
 	iwl_trans_pcie_free_pnvm_dram_regions(&trans_pcie->pnvm_data,
 					      trans->dev);
@@ -2749,7 +2894,7 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 	int pos = 0, i, ret;
 	size_t bufsz;
 
-	bufsz = sizeof(char) * 121 * trans->num_rx_queues;
+	bufsz = sizeof(char) * 211 * trans->num_rx_queues;
 
 	if (!trans_pcie->rxq)
 		return -EAGAIN;
@@ -2773,6 +2918,13 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 				 rxq->need_update);
 		pos += scnprintf(buf + pos, bufsz - pos, "\tfree_count: %u\n",
 				 rxq->free_count);
+		pos += scnprintf(buf + pos, bufsz - pos, "\tdoorbells: %u\n",
+				 rxq->doorbells);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\tRBDs per doorbell: %llu\n",
+				 rxq->doorbells ?
+				 div_u64(rxq->doorbell_rbds, rxq->doorbells) :
+				 0);
 		if (rxq->rb_stts) {
 			u32 r =	iwl_get_closed_rb_stts(trans, rxq);
 			pos += scnprintf(buf + pos, bufsz - pos,
@@ -2788,6 +2940,86 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 	return ret;
 }
 
+static ssize_t iwl_dbgfs_rx_stats_read(struct file *file,
+				       char __user *user_buf,
+				       size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	char *buf;
+	int pos = 0, i, ret;
+	size_t bufsz;
+
+	bufsz = sizeof(char) * 256 * trans->num_rx_queues;
+
+	if (!trans_pcie->rxq)
+		return -EAGAIN;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < trans->num_rx_queues && pos < bufsz; i++) {
+		struct iwl_trans_rxq_stats stats;
+
+		if (iwl_pcie_rxq_stats(trans, i, &stats))
+			break;
+
+		pos += scnprintf(buf + pos, bufsz - pos, "queue#: %2d\n", i);
+		pos += scnprintf(buf + pos, bufsz - pos, "\tpolls: %llu\n",
+				 stats.polls);
+		pos += scnprintf(buf + pos, bufsz - pos, "\tRBs: %llu\n",
+				 stats.rbs);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\tRBs per poll: %llu\n",
+				 stats.polls ?
+				 div64_u64(stats.rbs, stats.polls) : 0);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\tbudget exhausted: %llu\n",
+				 stats.budget_exhausted);
+		pos += scnprintf(buf + pos, bufsz - pos, "\temergency: %llu\n",
+				 stats.emergency);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\tpage steals: %llu\n", stats.page_steals);
+		pos += scnprintf(buf + pos, bufsz - pos, "\tRBs in use: %u\n",
+				 stats.rbs_in_use);
+	}
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
+static ssize_t iwl_dbgfs_tso_hdr_pool_read(struct file *file,
+					   char __user *user_buf,
+					   size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	char *buf;
+	int pos = 0, cpu, ret;
+	size_t bufsz;
+
+	bufsz = sizeof(char) * 64 * num_possible_cpus();
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct iwl_tso_hdr_page *p =
+			per_cpu_ptr(trans->txqs.tso_hdr_page, cpu);
+
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "cpu%d: pages %u fallback %lu\n",
+				 cpu, READ_ONCE(p->n_pages),
+				 READ_ONCE(p->fallback));
+	}
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
 static ssize_t iwl_dbgfs_interrupt_read(struct file *file,
 					char __user *user_buf,
 					size_t count, loff_t *ppos)
@@ -2933,6 +3165,86 @@ static ssize_t iwl_dbgfs_rfkill_write(struct file *file,
 	return count;
 }
 
+static ssize_t iwl_dbgfs_rx_affinity_read(struct file *file,
+					  char __user *user_buf,
+					  size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	int pos = 0, i, ret;
+	size_t bufsz;
+	char *buf;
+
+	bufsz = PAGE_SIZE;
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	mutex_lock(&trans_pcie->mutex);
+	if (trans_pcie->rx_affinity == IWL_PCIE_RX_AFFINITY_CPUS)
+		pos += scnprintf(buf + pos, bufsz - pos, "policy: %*pbl\n",
+				 cpumask_pr_args(&trans_pcie->rx_affinity_cpus));
+	else
+		pos += scnprintf(buf + pos, bufsz - pos, "policy: %s\n",
+				 iwl_pcie_rx_affinity_names[trans_pcie->rx_affinity]);
+
+	for (i = 0; trans_pcie->msix_enabled && i < trans_pcie->alloc_vecs;
+	     i++) {
+		if (cpumask_empty(&trans_pcie->affinity_mask[i]))
+			continue;
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "IRQ %d: %*pbl\n",
+				 trans_pcie->msix_entries[i].vector,
+				 cpumask_pr_args(&trans_pcie->affinity_mask[i]));
+	}
+	mutex_unlock(&trans_pcie->mutex);
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
+static ssize_t iwl_dbgfs_rx_affinity_write(struct file *file,
+					   const char __user *user_buf,
+					   size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	enum iwl_pcie_rx_affinity policy;
+	cpumask_var_t cpus;
+	char buf[256] = {};
+	int ret;
+
+	if (!trans_pcie->msix_enabled)
+		return -EOPNOTSUPP;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(buf, user_buf, count))
+		return -EFAULT;
+
+	if (!zalloc_cpumask_var(&cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = iwl_pcie_rx_affinity_parse(strim(buf), &policy, cpus);
+	if (ret)
+		goto out;
+
+	mutex_lock(&trans_pcie->mutex);
+	trans_pcie->rx_affinity = policy;
+	if (policy == IWL_PCIE_RX_AFFINITY_CPUS)
+		cpumask_copy(&trans_pcie->rx_affinity_cpus, cpus);
+	iwl_pcie_irq_set_affinity(trans);
+	mutex_unlock(&trans_pcie->mutex);
+
+	ret = count;
+out:
+	free_cpumask_var(cpus);
+	return ret;
+}
+
 static int iwl_dbgfs_monitor_data_open(struct inode *inode,
 				       struct file *file)
 {
@@ -3082,8 +3394,11 @@ static ssize_t iwl_dbgfs_rf_read(struct file *file,
 DEBUGFS_READ_WRITE_FILE_OPS(interrupt);
 DEBUGFS_READ_FILE_OPS(fh_reg);
 DEBUGFS_READ_FILE_OPS(rx_queue);
+DEBUGFS_READ_FILE_OPS(rx_stats);
+DEBUGFS_READ_FILE_OPS(tso_hdr_pool);
 DEBUGFS_WRITE_FILE_OPS(csr);
 DEBUGFS_READ_WRITE_FILE_OPS(rfkill);
+DEBUGFS_READ_WRITE_FILE_OPS(rx_affinity);
 DEBUGFS_READ_FILE_OPS(rf);
 
 static const struct file_operations iwl_dbgfs_tx_queue_ops = {
@@ -3103,16 +3418,22 @@ static const struct file_operations iwl_dbgfs_monitor_data_ops = {
 /* Create the debugfs files and directories */
 void iwl_trans_pcie_dbgfs_register(struct iwl_trans *trans)
 {
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 	struct dentry *dir = trans->dbgfs_dir;
 
 	DEBUGFS_ADD_FILE(rx_queue, dir, 0400);
+	DEBUGFS_ADD_FILE(rx_stats, dir, 0400);
+	DEBUGFS_ADD_FILE(rx_affinity, dir, 0600);
 	DEBUGFS_ADD_FILE(tx_queue, dir, 0400);
+	DEBUGFS_ADD_FILE(tso_hdr_pool, dir, 0400);
 	DEBUGFS_ADD_FILE(interrupt, dir, 0600);
 	DEBUGFS_ADD_FILE(csr, dir, 0200);
 	DEBUGFS_ADD_FILE(fh_reg, dir, 0400);
 	DEBUGFS_ADD_FILE(rfkill, dir, 0600);
 	DEBUGFS_ADD_FILE(monitor_data, dir, 0400);
 	DEBUGFS_ADD_FILE(rf, dir, 0400);
+	debugfs_create_u32("rx_restock_batch", 0600, dir,
+			   &trans_pcie->rx_restock_batch);
 }
 
 static void iwl_trans_pcie_debugfs_cleanup(struct iwl_trans *trans)
@@ -3593,7 +3914,8 @@ static void iwl_trans_pcie_sync_nmi(struct iwl_trans *trans)
 	.d3_resume = iwl_trans_pcie_d3_resume,				\
 	.interrupts = iwl_trans_pci_interrupts,				\
 	.sync_nmi = iwl_trans_pcie_sync_nmi,				\
-	.imr_dma_data = iwl_trans_pcie_copy_imr				\
+	.imr_dma_data = iwl_trans_pcie_copy_imr,			\
+	.rxq_stats = iwl_pcie_rxq_stats					\
 
 static const struct iwl_trans_ops trans_ops_pcie = {
 	IWL_TRANS_COMMON_OPS,
@@ -3689,6 +4011,7 @@ struct iwl_trans *iwl_trans_pcie_alloc(struct pci_dev *pdev,
 	init_waitqueue_head(&trans_pcie->ucode_write_waitq);
 	init_waitqueue_head(&trans_pcie->fw_reset_waitq);
 	init_waitqueue_head(&trans_pcie->imr_waitq);
+	trans_pcie->rx_restock_batch = RX_RESTOCK_BATCH_DEF;
 
 	trans_pcie->rba.alloc_wq = alloc_workqueue("rb_allocator",
 						   WQ_HIGHPRI | WQ_UNBOUND, 0);
@@ -142,9 +142,9 @@ int iwl_pcie_gen2_enqueue_hcmd(struct iwl_trans *trans,
 	out_cmd->hdr_wide.length =
 		cpu_to_le16(cmd_size - sizeof(struct iwl_cmd_header_wide));
 	out_cmd->hdr_wide.reserved = 0;
-	out_cmd->hdr_wide.sequence =
-		cpu_to_le16(QUEUE_TO_SEQ(trans->txqs.cmd.q_id) |
-					 INDEX_TO_SEQ(txq->write_ptr));
+	cmd->seq = QUEUE_TO_SEQ(trans->txqs.cmd.q_id) |
+		   INDEX_TO_SEQ(txq->write_ptr);
+	out_cmd->hdr_wide.sequence = cpu_to_le16(cmd->seq);
 
 	cmd_pos = sizeof(struct iwl_cmd_header_wide);
 	copy_size = sizeof(struct iwl_cmd_header_wide);
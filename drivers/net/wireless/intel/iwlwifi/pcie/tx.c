@@ -193,7 +193,8 @@ static void iwl_pcie_txq_unmap(struct iwl_trans *trans, int txq_id)
 		return;
 	}
 
-	spin_lock_bh(&txq->lock);
+	spin_lock_bh(&txq->reclaim_lock);
+	spin_lock(&txq->lock);
 	while (txq->write_ptr != txq->read_ptr) {
 		IWL_DEBUG_TX_REPLY(trans, "Q %d Free %d\n",
 				   txq_id, txq->read_ptr);
@@ -207,7 +208,8 @@ static void iwl_pcie_txq_unmap(struct iwl_trans *trans, int txq_id)
 			iwl_txq_free_tso_page(trans, skb);
 		}
 		iwl_txq_free_tfd(trans, txq);
-		txq->read_ptr = iwl_txq_inc_wrap(trans, txq->read_ptr);
+		iwl_txq_set_read_ptr(txq,
+				     iwl_txq_inc_wrap(trans, txq->read_ptr));
 
 		if (txq->read_ptr == txq->write_ptr &&
 		    txq_id == trans->txqs.cmd.q_id)
@@ -220,7 +222,8 @@ static void iwl_pcie_txq_unmap(struct iwl_trans *trans, int txq_id)
 		iwl_op_mode_free_skb(trans->op_mode, skb);
 	}
 
-	spin_unlock_bh(&txq->lock);
+	spin_unlock(&txq->lock);
+	spin_unlock_bh(&txq->reclaim_lock);
 
 	/* just in case - this queue may have been stopped */
 	iwl_wake_queue(trans, txq);
@@ -1028,6 +1031,9 @@ int iwl_pcie_enqueue_hcmd(struct iwl_trans *trans,
 	if (cmd->flags & CMD_WANT_SKB)
 		out_meta->source = cmd;
 
+	cmd->seq = QUEUE_TO_SEQ(trans->txqs.cmd.q_id) |
+		   INDEX_TO_SEQ(txq->write_ptr);
+
 	/* set up the header */
 	if (group_id != 0) {
 		out_cmd->hdr_wide.cmd = iwl_cmd_opcode(cmd->id);
@@ -1037,17 +1043,13 @@ int iwl_pcie_enqueue_hcmd(struct iwl_trans *trans,
 			cpu_to_le16(cmd_size -
 				    sizeof(struct iwl_cmd_header_wide));
 		out_cmd->hdr_wide.reserved = 0;
-		out_cmd->hdr_wide.sequence =
-			cpu_to_le16(QUEUE_TO_SEQ(trans->txqs.cmd.q_id) |
-						 INDEX_TO_SEQ(txq->write_ptr));
+		out_cmd->hdr_wide.sequence = cpu_to_le16(cmd->seq);
 
 		cmd_pos = sizeof(struct iwl_cmd_header_wide);
 		copy_size = sizeof(struct iwl_cmd_header_wide);
 	} else {
 		out_cmd->hdr.cmd = iwl_cmd_opcode(cmd->id);
-		out_cmd->hdr.sequence =
-			cpu_to_le16(QUEUE_TO_SEQ(trans->txqs.cmd.q_id) |
-						 INDEX_TO_SEQ(txq->write_ptr));
+		out_cmd->hdr.sequence = cpu_to_le16(cmd->seq);
 		out_cmd->hdr.group_id = 0;
 
 		cmd_pos = sizeof(struct iwl_cmd_header);
@@ -1371,6 +1373,7 @@ static int iwl_fill_data_tbs_amsdu(struct iwl_trans *trans, struct sk_buff *skb,
 		unsigned int hdr_tb_len;
 		dma_addr_t hdr_tb_phys;
 		u8 *subf_hdrs_start = hdr_page->pos;
+		int tb_idx;
 
 		total_len -= data_left;
 
@@ -1396,12 +1399,14 @@ static int iwl_fill_data_tbs_amsdu(struct iwl_trans *trans, struct sk_buff *skb,
 		hdr_page->pos += snap_ip_tcp_hdrlen;
 
 		hdr_tb_len = hdr_page->pos - start_hdr;
-		hdr_tb_phys = dma_map_single(trans->dev, start_hdr,
-					     hdr_tb_len, DMA_TO_DEVICE);
-		if (unlikely(dma_mapping_error(trans->dev, hdr_tb_phys)))
+		hdr_tb_phys = iwl_txq_tso_hdr_sync(trans, hdr_page, start_hdr,
+						   hdr_tb_len);
+		tb_idx = iwl_pcie_txq_build_tfd(trans, txq, hdr_tb_phys,
+						hdr_tb_len, false);
+		if (tb_idx < 0)
 			return -EINVAL;
-		iwl_pcie_txq_build_tfd(trans, txq, hdr_tb_phys,
-				       hdr_tb_len, false);
+		/* the TSO page stays mapped, don't unmap this TB */
+		out_meta->tso_hdr_tbs |= BIT(tb_idx);
 		trace_iwlwifi_dev_tx_tb(trans->dev, skb, start_hdr,
 					hdr_tb_phys, hdr_tb_len);
 		/* add this subframe's headers' length to the tx_cmd */
@@ -1619,7 +1624,7 @@ int iwl_trans_pcie_tx(struct iwl_trans *trans, struct sk_buff *skb,
 	wait_write_ptr = ieee80211_has_morefrags(fc);
 
 	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout) {
+	if (iwl_txq_get_read_ptr(txq) == txq->write_ptr && txq->wd_timeout) {
 		/*
 		 * If the TXQ is active, then set the timer, if not,
 		 * set the timer in remainder so that the timer will
@@ -1634,7 +1639,7 @@ int iwl_trans_pcie_tx(struct iwl_trans *trans, struct sk_buff *skb,
 	}
 
 	/* Tell device the write index *just past* this latest filled TFD */
-	txq->write_ptr = iwl_txq_inc_wrap(trans, txq->write_ptr);
+	iwl_txq_set_write_ptr(txq, iwl_txq_inc_wrap(trans, txq->write_ptr));
 	if (!wait_write_ptr)
 		iwl_pcie_txq_inc_wr_ptr(trans, txq);
 
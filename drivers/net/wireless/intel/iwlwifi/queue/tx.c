@@ -6,6 +6,7 @@
 #include <linux/tcp.h>
 
 #include "iwl-debug.h"
+#include "iwl-drv.h"
 #include "iwl-io.h"
 #include "fw/api/commands.h"
 #include "fw/api/tx.h"
@@ -145,6 +146,9 @@ void iwl_txq_gen2_tfd_unmap(struct iwl_trans *trans, struct iwl_cmd_meta *meta,
 
 	/* first TB is never freed - it's the bidirectional DMA data */
 	for (i = 1; i < num_tbs; i++) {
+		if (meta->tso_hdr_tbs & BIT(i))
+			continue;
+
 		if (meta->tbs & BIT(i))
 			dma_unmap_page(trans->dev,
 				       le64_to_cpu(tfd->tbs[i].addr),
@@ -157,6 +161,8 @@ void iwl_txq_gen2_tfd_unmap(struct iwl_trans *trans, struct iwl_cmd_meta *meta,
 					 DMA_TO_DEVICE);
 	}
 
+	meta->tso_hdr_tbs = 0;
+
 	iwl_txq_set_tfd_invalid_gen2(trans, tfd);
 }
 
@@ -168,7 +174,7 @@ void iwl_txq_gen2_free_tfd(struct iwl_trans *trans, struct iwl_txq *txq)
 	int idx = iwl_txq_get_cmd_index(txq, txq->read_ptr);
 	struct sk_buff *skb;
 
-	lockdep_assert_held(&txq->lock);
+	lockdep_assert_held(&txq->reclaim_lock);
 
 	if (!txq->entries)
 		return;
@@ -289,11 +295,77 @@ trace:
 	return ret;
 }
 
+static void iwl_txq_put_tso_page(struct iwl_trans *trans, struct page *page)
+{
+	struct iwl_tso_page_info *info = IWL_TSO_PAGE_INFO(page_address(page));
+	struct iwl_tso_hdr_page *p;
+
+	if (!refcount_dec_and_test(&info->use_count))
+		return;
+
+	if (info->cpu < 0) {
+		dma_unmap_page(trans->dev, info->dma_addr, PAGE_SIZE,
+			       DMA_TO_DEVICE);
+		__free_page(page);
+		return;
+	}
+
+	/* reclaim may run on any CPU, return it to the pool it came from */
+	p = per_cpu_ptr(trans->txqs.tso_hdr_page, info->cpu);
+	llist_add(&info->free_node, &p->returned);
+}
+
 #ifdef CONFIG_INET
+static struct page *iwl_txq_alloc_tso_page(struct iwl_trans *trans,
+					   struct iwl_tso_hdr_page *p)
+{
+	struct iwl_tso_page_info *info;
+	struct llist_node *node;
+	struct page *page;
+	dma_addr_t phys;
+
+	if (!p->free)
+		p->free = llist_del_all(&p->returned);
+
+	if (p->free) {
+		node = p->free;
+		p->free = node->next;
+		info = container_of(node, struct iwl_tso_page_info, free_node);
+		page = virt_to_page(info);
+		goto out;
+	}
+
+	page = alloc_page(GFP_ATOMIC);
+	if (!page)
+		return NULL;
+
+	phys = dma_map_page(trans->dev, page, 0, PAGE_SIZE, DMA_TO_DEVICE);
+	if (unlikely(dma_mapping_error(trans->dev, phys))) {
+		__free_page(page);
+		return NULL;
+	}
+
+	info = IWL_TSO_PAGE_INFO(page_address(page));
+	info->dma_addr = phys;
+
+	if (p->n_pages < IWL_TSO_PAGE_POOL_SIZE) {
+		info->cpu = smp_processor_id();
+		p->n_pages++;
+	} else {
+		info->cpu = -1;
+		p->fallback++;
+	}
+out:
+	/* the reference held while this is the current page of the CPU */
+	refcount_set(&info->use_count, 1);
+	return page;
+}
+
 struct iwl_tso_hdr_page *get_page_hdr(struct iwl_trans *trans, size_t len,
 				      struct sk_buff *skb)
 {
 	struct iwl_tso_hdr_page *p = this_cpu_ptr(trans->txqs.tso_hdr_page);
+	struct iwl_tso_page_info *info;
 	struct page **page_ptr;
 
 	page_ptr = (void *)((u8 *)skb->cb + trans->txqs.page_offs);
@@ -307,30 +379,25 @@ struct iwl_tso_hdr_page *get_page_hdr(struct iwl_trans *trans, size_t len,
 	/*
 	 * Check if there's enough room on this page
 	 *
-	 * Note that we put a page chaining pointer *last* in the
-	 * page - we need it somewhere, and if it's there then we
-	 * avoid DMA mapping the last bits of the page which may
-	 * trigger the 32-bit boundary hardware bug.
-	 *
-	 * (see also get_workaround_page() in tx-gen2.c)
+	 * Note that the page information is kept *last* in the page,
+	 * see struct iwl_tso_page_info.
 	 */
-	if (p->pos + len < (u8 *)page_address(p->page) + PAGE_SIZE -
-			   sizeof(void *))
+	if (p->pos + len < (u8 *)page_address(p->page) +
+			   IWL_TSO_PAGE_DATA_SIZE)
 		goto out;
 
 	/* We don't have enough room on this page, get a new one. */
-	__free_page(p->page);
+	iwl_txq_put_tso_page(trans, p->page);
 
 alloc:
-	p->page = alloc_page(GFP_ATOMIC);
+	p->page = iwl_txq_alloc_tso_page(trans, p);
 	if (!p->page)
 		return NULL;
 	p->pos = page_address(p->page);
-	/* set the chaining pointer to NULL */
-	*(void **)((u8 *)page_address(p->page) + PAGE_SIZE - sizeof(void *)) = NULL;
 out:
-	*page_ptr = p->page;
-	get_page(p->page);
+	info = IWL_TSO_PAGE_INFO(page_address(p->page));
+	refcount_inc(&info->use_count);
+	*page_ptr = (void *)((unsigned long)p->page | IWL_TSO_PAGE_TAG);
 	return p;
 }
 #endif
@@ -339,6 +406,7 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 				    struct sk_buff *skb,
 				    struct iwl_tfh_tfd *tfd, int start_len,
 				    u8 hdr_len,
+				    struct iwl_cmd_meta *out_meta,
 				    struct iwl_device_tx_cmd *dev_cmd)
 {
 #ifdef CONFIG_INET
@@ -390,6 +458,7 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 		unsigned int data_left = min_t(unsigned int, mss, total_len);
 		unsigned int tb_len;
 		dma_addr_t tb_phys;
+		int tb_idx;
 		u8 *subf_hdrs_start = hdr_page->pos;
 
 		total_len -= data_left;
@@ -416,16 +485,18 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 		hdr_page->pos += snap_ip_tcp_hdrlen;
 
 		tb_len = hdr_page->pos - start_hdr;
-		tb_phys = dma_map_single(trans->dev, start_hdr,
-					 tb_len, DMA_TO_DEVICE);
-		if (unlikely(dma_mapping_error(trans->dev, tb_phys)))
-			goto out_err;
+		tb_phys = iwl_txq_tso_hdr_sync(trans, hdr_page, start_hdr,
+					       tb_len);
 		/*
 		 * No need for _with_wa, this is from the TSO page and
 		 * we leave some space at the end of it so can't hit
 		 * the buggy scenario.
 		 */
-		iwl_txq_gen2_set_tb(trans, tfd, tb_phys, tb_len);
+		tb_idx = iwl_txq_gen2_set_tb(trans, tfd, tb_phys, tb_len);
+		if (tb_idx < 0)
+			goto out_err;
+		/* the TSO page stays mapped, don't unmap this TB */
+		out_meta->tso_hdr_tbs |= BIT(tb_idx);
 		trace_iwlwifi_dev_tx_tb(trans->dev, skb, start_hdr,
 					tb_phys, tb_len);
 		/* add this subframe's headers' length to the tx_cmd */
@@ -509,7 +580,7 @@ iwl_tfh_tfd *iwl_txq_gen2_build_tx_amsdu(struct iwl_trans *trans,
 	iwl_txq_gen2_set_tb(trans, tfd, tb_phys, len);
 
 	if (iwl_txq_gen2_build_amsdu(trans, skb, tfd, len + IWL_FIRST_TB_SIZE,
-				     hdr_len, dev_cmd))
+				     hdr_len, out_meta, dev_cmd))
 		goto out_err;
 
 	/* building the A-MSDU might have changed this data, memcpy it now */
@@ -712,7 +783,7 @@ int iwl_txq_space(struct iwl_trans *trans, const struct iwl_txq *q)
 	 * max_tfd_queue_size is a power of 2, so the following is equivalent to
 	 * modulo by max_tfd_queue_size and is well defined.
 	 */
-	used = (q->write_ptr - q->read_ptr) &
+	used = (iwl_txq_get_write_ptr(q) - iwl_txq_get_read_ptr(q)) &
 		(trans->trans_cfg->base_params->max_tfd_queue_size - 1);
 
 	if (WARN_ON(used > max))
@@ -720,6 +791,7 @@ int iwl_txq_space(struct iwl_trans *trans, const struct iwl_txq *q)
 
 	return max - used;
 }
+EXPORT_SYMBOL_IF_IWLWIFI_KUNIT(iwl_txq_space);
 
 int iwl_txq_gen2_tx(struct iwl_trans *trans, struct sk_buff *skb,
 		    struct iwl_device_tx_cmd *dev_cmd, int txq_id)
@@ -799,11 +871,11 @@ int iwl_txq_gen2_tx(struct iwl_trans *trans, struct sk_buff *skb,
 				      iwl_txq_gen2_get_num_tbs(trans, tfd));
 
 	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout)
+	if (iwl_txq_get_read_ptr(txq) == txq->write_ptr && txq->wd_timeout)
 		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
 
 	/* Tell device the write index *just past* this latest filled TFD */
-	txq->write_ptr = iwl_txq_inc_wrap(trans, txq->write_ptr);
+	iwl_txq_set_write_ptr(txq, iwl_txq_inc_wrap(trans, txq->write_ptr));
 	iwl_txq_inc_wr_ptr(trans, txq);
 	/*
 	 * At this point the frame is "transmitted" successfully
@@ -822,7 +894,8 @@ void iwl_txq_gen2_unmap(struct iwl_trans *trans, int txq_id)
 {
 	struct iwl_txq *txq = trans->txqs.txq[txq_id];
 
-	spin_lock_bh(&txq->lock);
+	spin_lock_bh(&txq->reclaim_lock);
+	spin_lock(&txq->lock);
 	while (txq->write_ptr != txq->read_ptr) {
 		IWL_DEBUG_TX_REPLY(trans, "Q %d Free %d\n",
 				   txq_id, txq->read_ptr);
@@ -835,7 +908,8 @@ void iwl_txq_gen2_unmap(struct iwl_trans *trans, int txq_id)
 				iwl_txq_free_tso_page(trans, skb);
 		}
 		iwl_txq_gen2_free_tfd(trans, txq);
-		txq->read_ptr = iwl_txq_inc_wrap(trans, txq->read_ptr);
+		iwl_txq_set_read_ptr(txq,
+				     iwl_txq_inc_wrap(trans, txq->read_ptr));
 	}
 
 	while (!skb_queue_empty(&txq->overflow_q)) {
@@ -844,7 +918,8 @@ void iwl_txq_gen2_unmap(struct iwl_trans *trans, int txq_id)
 		iwl_op_mode_free_skb(trans->op_mode, skb);
 	}
 
-	spin_unlock_bh(&txq->lock);
+	spin_unlock(&txq->lock);
+	spin_unlock_bh(&txq->reclaim_lock);
 
 	/* just in case - this queue may have been stopped */
 	iwl_wake_queue(trans, txq);
@@ -959,6 +1034,7 @@ int iwl_txq_init(struct iwl_trans *trans, struct iwl_txq *txq, int slots_num,
 		return ret;
 
 	spin_lock_init(&txq->lock);
+	spin_lock_init(&txq->reclaim_lock);
 
 	if (cmd_queue) {
 		static struct lock_class_key iwl_txq_cmd_queue_lock_class;
@@ -983,12 +1059,52 @@ void iwl_txq_free_tso_page(struct iwl_trans *trans, struct sk_buff *skb)
 	while (next) {
 		struct page *tmp = next;
 
+		/* the TSO header page, if any, is always last in the chain */
+		if ((unsigned long)tmp & IWL_TSO_PAGE_TAG) {
+			iwl_txq_put_tso_page(trans,
+					     (void *)((unsigned long)tmp &
+						      ~IWL_TSO_PAGE_TAG));
+			break;
+		}
+
 		next = *(void **)((u8 *)page_address(next) + PAGE_SIZE -
 				  sizeof(void *));
 		__free_page(tmp);
 	}
 }
 
+static void iwl_txq_free_tso_page_list(struct iwl_trans *trans,
+				       struct llist_node *list)
+{
+	struct iwl_tso_page_info *info, *tmp;
+
+	llist_for_each_entry_safe(info, tmp, list, free_node) {
+		dma_unmap_page(trans->dev, info->dma_addr, PAGE_SIZE,
+			       DMA_TO_DEVICE);
+		__free_page(virt_to_page(info));
+	}
+}
+
+void iwl_txq_free_tso_hdr_pages(struct iwl_trans *trans)
+{
+	int i;
+
+	for_each_possible_cpu(i) {
+		struct iwl_tso_hdr_page *p =
+			per_cpu_ptr(trans->txqs.tso_hdr_page, i);
+
+		if (p->page)
+			iwl_txq_put_tso_page(trans, p->page);
+		p->page = NULL;
+
+		iwl_txq_free_tso_page_list(trans, p->free);
+		p->free = NULL;
+		iwl_txq_free_tso_page_list(trans,
+					   llist_del_all(&p->returned));
+		p->n_pages = 0;
+	}
+}
+
 void iwl_txq_log_scd_error(struct iwl_trans *trans, struct iwl_txq *txq)
 {
 	u32 txq_id = txq->id;
@@ -1026,7 +1142,7 @@ static void iwl_txq_stuck_timer(struct timer_list *t)
 
 	spin_lock(&txq->lock);
 	/* check if triggered erroneously */
-	if (txq->read_ptr == txq->write_ptr) {
+	if (iwl_txq_get_read_ptr(txq) == txq->write_ptr) {
 		spin_unlock(&txq->lock);
 		return;
 	}
@@ -1409,6 +1525,9 @@ void iwl_txq_gen1_tfd_unmap(struct iwl_trans *trans,
 	/* first TB is never freed - it's the bidirectional DMA data */
 
 	for (i = 1; i < num_tbs; i++) {
+		if (meta->tso_hdr_tbs & BIT(i))
+			continue;
+
 		if (meta->tbs & BIT(i))
 			dma_unmap_page(trans->dev,
 				       iwl_txq_gen1_tfd_tb_get_addr(trans,
@@ -1426,6 +1545,7 @@ void iwl_txq_gen1_tfd_unmap(struct iwl_trans *trans,
 	}
 
 	meta->tbs = 0;
+	meta->tso_hdr_tbs = 0;
 
 	iwl_txq_set_tfd_invalid_gen1(trans, tfd);
 }
@@ -1523,7 +1643,7 @@ void iwl_txq_free_tfd(struct iwl_trans *trans, struct iwl_txq *txq)
 	int idx = iwl_txq_get_cmd_index(txq, rd_ptr);
 	struct sk_buff *skb;
 
-	lockdep_assert_held(&txq->lock);
+	lockdep_assert_held(&txq->reclaim_lock);
 
 	if (!txq->entries)
 		return;
@@ -1569,7 +1689,7 @@ void iwl_txq_progress(struct iwl_txq *txq)
 	 * if empty delete timer, otherwise move timer forward
 	 * since we're making progress on this queue
 	 */
-	if (txq->read_ptr == txq->write_ptr)
+	if (iwl_txq_get_read_ptr(txq) == txq->write_ptr)
 		del_timer(&txq->stuck_timer);
 	else
 		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
@@ -1589,11 +1709,17 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 	if (WARN_ON(!txq))
 		return;
 
+	/*
+	 * Only the consumer side lock is taken here, so the TX path can keep
+	 * filling the queue while we unmap and free the completed entries.
+	 * txq->lock is only needed below for the timer and the stop/wake
+	 * decision, which must be serialized against the TX path.
+	 */
+	spin_lock_bh(&txq->reclaim_lock);
+
 	tfd_num = iwl_txq_get_cmd_index(txq, ssn);
 	read_ptr = iwl_txq_get_cmd_index(txq, txq->read_ptr);
 
-	spin_lock_bh(&txq->lock);
-
 	if (!test_bit(txq_id, trans->txqs.queue_used)) {
 		IWL_DEBUG_TX_QUEUES(trans, "Q %d inactive - ignoring idx %d\n",
 				    txq_id, ssn);
@@ -1615,7 +1741,7 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 			"%s: Read index for txq id (%d), last_to_free %d is out of range [0-%d] %d %d.\n",
 			__func__, txq_id, last_to_free,
 			trans->trans_cfg->base_params->max_tfd_queue_size,
-			txq->write_ptr, txq->read_ptr);
+			iwl_txq_get_write_ptr(txq), txq->read_ptr);
 
 		iwl_op_mode_time_point(trans->op_mode,
 				       IWL_FW_INI_TIME_POINT_FAKE_TX,
@@ -1628,7 +1754,7 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 
 	for (;
 	     read_ptr != tfd_num;
-	     txq->read_ptr = iwl_txq_inc_wrap(trans, txq->read_ptr),
+	     iwl_txq_set_read_ptr(txq, iwl_txq_inc_wrap(trans, txq->read_ptr)),
 	     read_ptr = iwl_txq_get_cmd_index(txq, txq->read_ptr)) {
 		struct sk_buff *skb = txq->entries[read_ptr].skb;
 
@@ -1647,6 +1773,8 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 		iwl_txq_free_tfd(trans, txq);
 	}
 
+	spin_lock(&txq->lock);
+
 	iwl_txq_progress(txq);
 
 	if (iwl_txq_space(trans, txq) > txq->low_mark &&
@@ -1669,12 +1797,12 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 
 		/*
 		 * This is tricky: we are in reclaim path which is non
-		 * re-entrant, so noone will try to take the access the
-		 * txq data from that path. We stopped tx, so we can't
-		 * have tx as well. Bottom line, we can unlock and re-lock
-		 * later.
+		 * re-entrant (reclaim_lock is still held), so noone will
+		 * try to take the access the txq data from that path. We
+		 * stopped tx, so we can't have tx as well. Bottom line, we
+		 * can unlock and re-lock later.
 		 */
-		spin_unlock_bh(&txq->lock);
+		spin_unlock(&txq->lock);
 
 		while ((skb = __skb_dequeue(&overflow_skbs))) {
 			struct iwl_device_tx_cmd *dev_cmd_ptr;
@@ -1693,12 +1821,13 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 		if (iwl_txq_space(trans, txq) > txq->low_mark)
 			iwl_wake_queue(trans, txq);
 
-		spin_lock_bh(&txq->lock);
+		spin_lock(&txq->lock);
 		txq->overflow_tx = false;
 	}
 
+	spin_unlock(&txq->lock);
 out:
-	spin_unlock_bh(&txq->lock);
+	spin_unlock_bh(&txq->reclaim_lock);
 }
 
 /* Set wr_ptr of specific device and txq  */
@@ -1706,12 +1835,14 @@ void iwl_txq_set_q_ptrs(struct iwl_trans *trans, int txq_id, int ptr)
 {
 	struct iwl_txq *txq = trans->txqs.txq[txq_id];
 
-	spin_lock_bh(&txq->lock);
+	spin_lock_bh(&txq->reclaim_lock);
+	spin_lock(&txq->lock);
 
 	txq->write_ptr = ptr;
 	txq->read_ptr = txq->write_ptr;
 
-	spin_unlock_bh(&txq->lock);
+	spin_unlock(&txq->lock);
+	spin_unlock_bh(&txq->reclaim_lock);
 }
 
 void iwl_trans_txq_freeze_timer(struct iwl_trans *trans, unsigned long txqs,
@@ -1735,7 +1866,7 @@ void iwl_trans_txq_freeze_timer(struct iwl_trans *trans, unsigned long txqs,
 
 		txq->frozen = freeze;
 
-		if (txq->read_ptr == txq->write_ptr)
+		if (iwl_txq_get_read_ptr(txq) == txq->write_ptr)
 			goto next_queue;
 
 		if (freeze) {
@@ -7,11 +7,75 @@
 #include "iwl-fh.h"
 #include "fw/api/tx.h"
 
+/* number of pre-mapped TSO header pages each CPU keeps for reuse */
+#define IWL_TSO_PAGE_POOL_SIZE	8
+
+/*
+ * The TSO header page pointer stored in the skb is tagged with this bit,
+ * so it can be told apart from the workaround pages chained before it.
+ */
+#define IWL_TSO_PAGE_TAG	BIT(0)
+
+/**
+ * struct iwl_tso_page_info - TSO header page information
+ *
+ * Kept at the end of each TSO header page, which also avoids mapping
+ * the last bits of the page which may trigger the 32-bit boundary
+ * hardware bug.
+ *
+ * @dma_addr: DMA address the whole page is mapped at
+ * @free_node: entry in the free list of the owning CPU's pool
+ * @use_count: one reference for each skb using the page, and one
+ *	while it's the current page of its CPU
+ * @cpu: CPU whose pool the page is returned to, or -1 if the page
+ *	was allocated when that pool was full and is freed after use
+ */
+struct iwl_tso_page_info {
+	dma_addr_t dma_addr;
+	struct llist_node free_node;
+	refcount_t use_count;
+	int cpu;
+};
+
+#define IWL_TSO_PAGE_DATA_SIZE	(PAGE_SIZE - sizeof(struct iwl_tso_page_info))
+#define IWL_TSO_PAGE_INFO(addr)	\
+	((struct iwl_tso_page_info *)((u8 *)(addr) + IWL_TSO_PAGE_DATA_SIZE))
+
+/**
+ * struct iwl_tso_hdr_page - per-CPU TSO header page pool
+ *
+ * @page: page the headers are currently written to
+ * @pos: position of the next header in @page
+ * @free: pages ready for reuse, only accessed by the owning CPU
+ * @returned: pages released on TX reclaim, on any CPU
+ * @n_pages: number of pages owned by the pool
+ * @fallback: number of pages allocated while the pool was exhausted
+ */
 struct iwl_tso_hdr_page {
 	struct page *page;
 	u8 *pos;
+	struct llist_node *free;
+	struct llist_head returned;
+	unsigned int n_pages;
+	unsigned long fallback;
 };
 
+/*
+ * The TSO header pages are DMA mapped when they're allocated, so
+ * handing a range of one to the device only needs to sync it.
+ */
+static inline dma_addr_t iwl_txq_tso_hdr_sync(struct iwl_trans *trans,
+					      struct iwl_tso_hdr_page *p,
+					      u8 *start, unsigned int len)
+{
+	u8 *addr = page_address(p->page);
+	dma_addr_t phys = IWL_TSO_PAGE_INFO(addr)->dma_addr + (start - addr);
+
+	dma_sync_single_for_device(trans->dev, phys, len, DMA_TO_DEVICE);
+
+	return phys;
+}
+
 static inline dma_addr_t
 iwl_txq_get_first_tb_dma(struct iwl_txq *txq, int idx)
 {
@@ -24,6 +88,32 @@ static inline u16 iwl_txq_get_cmd_index(const struct iwl_txq *q, u32 index)
 	return index & (q->n_window - 1);
 }
 
+/*
+ * Data queues have a single producer (TX, under txq->lock) and a single
+ * consumer (reclaim, under txq->reclaim_lock). Each side owns one index
+ * and publishes it only once it's done with the entries it covers, so
+ * the other side reads it with acquire semantics before touching them.
+ */
+static inline void iwl_txq_set_write_ptr(struct iwl_txq *txq, int ptr)
+{
+	smp_store_release(&txq->write_ptr, ptr);
+}
+
+static inline void iwl_txq_set_read_ptr(struct iwl_txq *txq, int ptr)
+{
+	smp_store_release(&txq->read_ptr, ptr);
+}
+
+static inline int iwl_txq_get_write_ptr(const struct iwl_txq *txq)
+{
+	return smp_load_acquire(&txq->write_ptr);
+}
+
+static inline int iwl_txq_get_read_ptr(const struct iwl_txq *txq)
+{
+	return smp_load_acquire(&txq->read_ptr);
+}
+
 void iwl_txq_gen2_unmap(struct iwl_trans *trans, int txq_id);
 
 static inline void iwl_wake_queue(struct iwl_trans *trans,
@@ -94,8 +184,8 @@ static inline int iwl_txq_dec_wrap(struct iwl_trans *trans, int index)
 static inline bool iwl_txq_used(const struct iwl_txq *q, int i)
 {
 	int index = iwl_txq_get_cmd_index(q, i);
-	int r = iwl_txq_get_cmd_index(q, q->read_ptr);
-	int w = iwl_txq_get_cmd_index(q, q->write_ptr);
+	int r = iwl_txq_get_cmd_index(q, iwl_txq_get_read_ptr(q));
+	int w = iwl_txq_get_cmd_index(q, iwl_txq_get_write_ptr(q));
 
 	return w >= r ?
 		(index >= r && index < w) :
@@ -103,6 +193,7 @@ static inline bool iwl_txq_used(const struct iwl_txq *q, int i)
 }
 
 void iwl_txq_free_tso_page(struct iwl_trans *trans, struct sk_buff *skb);
+void iwl_txq_free_tso_hdr_pages(struct iwl_trans *trans);
 
 void iwl_txq_log_scd_error(struct iwl_trans *trans, struct iwl_txq *txq);
 
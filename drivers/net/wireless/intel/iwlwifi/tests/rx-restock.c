@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/*
+ * KUnit tests for the PCIe RX restock doorbell batching
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include "pcie/internal.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+#define TEST_QUEUE_SIZE	512
+#define TEST_BATCH	32
+
+static const struct rx_restock_case {
+	const char *desc;
+	u32 read, write, write_actual;
+	bool doorbell;
+} rx_restock_cases[] = {
+	{
+		.desc = "nothing restocked",
+		.read = 100, .write = 40, .write_actual = 40,
+		.doorbell = false,
+	},
+	{
+		.desc = "less than 8 restocked",
+		.read = 100, .write = 47, .write_actual = 40,
+		.doorbell = false,
+	},
+	{
+		.desc = "below batch, device has enough",
+		.read = 100, .write = 56, .write_actual = 40,
+		.doorbell = false,
+	},
+	{
+		.desc = "batch reached",
+		.read = 100, .write = 72, .write_actual = 40,
+		.doorbell = true,
+	},
+	{
+		.desc = "below batch, device running low",
+		.read = 500, .write = 56, .write_actual = 40,
+		.doorbell = true,
+	},
+	{
+		.desc = "below batch, wrap-around",
+		.read = 300, .write = 8, .write_actual = 504,
+		.doorbell = false,
+	},
+	{
+		.desc = "batch reached, wrap-around",
+		.read = 300, .write = 24, .write_actual = 488,
+		.doorbell = true,
+	},
+	{
+		.desc = "initial restock",
+		.read = 0, .write = 8, .write_actual = 0,
+		.doorbell = true,
+	},
+};
+
+KUNIT_ARRAY_PARAM_DESC(rx_restock, rx_restock_cases, desc);
+
+static void rx_restock_doorbell(struct kunit *test)
+{
+	const struct rx_restock_case *params = test->param_value;
+	struct iwl_rxq rxq = {
+		.queue_size = TEST_QUEUE_SIZE,
+		.read = params->read,
+		.write = params->write,
+		.write_actual = params->write_actual,
+	};
+
+	KUNIT_EXPECT_EQ(test, params->doorbell,
+			iwl_pcie_rxq_doorbell_needed(&rxq, TEST_BATCH));
+}
+
+/*
+ * Run a fake queue: the device fills a few RBs per poll, the driver
+ * handles and restocks them, and updates the write pointer the way
+ * iwl_pcie_rxq_inc_wr_ptr() does. Check that the doorbells are batched
+ * and that the device never runs out of RBDs.
+ */
+static void rx_restock_batching(struct kunit *test)
+{
+	struct iwl_rxq rxq = {
+		.queue_size = TEST_QUEUE_SIZE,
+	};
+	u32 mask = TEST_QUEUE_SIZE - 1;
+	u32 restocked = 0, doorbells = 0;
+	int poll;
+
+	/* initially the whole queue is given to the device */
+	rxq.write = TEST_QUEUE_SIZE - 8;
+	rxq.write_actual = rxq.write;
+
+	for (poll = 0; poll < 10000; poll++) {
+		u32 posted = (rxq.write_actual - rxq.read) & mask;
+		u32 filled = 1 + poll % 7;
+
+		KUNIT_ASSERT_GT(test, posted, 0);
+		filled = min(filled, posted);
+
+		/* handle the RBs the device filled and restock them */
+		rxq.read = (rxq.read + filled) & mask;
+		rxq.write = (rxq.write + filled) & mask;
+		restocked += filled;
+
+		if (iwl_pcie_rxq_doorbell_needed(&rxq, TEST_BATCH)) {
+			rxq.write_actual = round_down(rxq.write, 8);
+			doorbells++;
+		}
+	}
+
+	KUNIT_EXPECT_GT(test, doorbells, 0);
+	KUNIT_EXPECT_GE(test, restocked / doorbells, TEST_BATCH);
+}
+
+static struct kunit_case rx_restock_test_cases[] = {
+	KUNIT_CASE_PARAM(rx_restock_doorbell, rx_restock_gen_params),
+	KUNIT_CASE(rx_restock_batching),
+	{}
+};
+
+static struct kunit_suite iwlwifi_rx_restock = {
+	.name = "iwlwifi-rx-restock",
+	.test_cases = rx_restock_test_cases,
+};
+
+kunit_test_suite(iwlwifi_rx_restock);
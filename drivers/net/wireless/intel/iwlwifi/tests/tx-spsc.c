@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/*
+ * KUnit tests for the lock-free TX queue index handoff
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include "iwl-trans.h"
+#include "queue/tx.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+#define TX_SPSC_QUEUE_SIZE	256
+#define TX_SPSC_WINDOW		64
+#define TX_SPSC_FRAMES		2000000
+
+struct tx_spsc {
+	struct iwl_trans *trans;
+	struct iwl_txq *txq;
+	u32 *slots;
+	struct completion done[2];
+	unsigned int overruns, reordered;
+};
+
+static const struct iwl_base_params tx_spsc_base_params = {
+	.max_tfd_queue_size = TX_SPSC_QUEUE_SIZE,
+};
+
+static const struct iwl_cfg_trans_params tx_spsc_trans_cfg = {
+	.base_params = &tx_spsc_base_params,
+};
+
+/* mimics the TX path: fill the entry, then publish the write pointer */
+static int tx_spsc_producer(void *data)
+{
+	struct tx_spsc *s = data;
+	struct iwl_txq *txq = s->txq;
+	u32 seq = 1;
+
+	while (seq <= TX_SPSC_FRAMES) {
+		int idx;
+
+		if (!iwl_txq_space(s->trans, txq)) {
+			cond_resched();
+			continue;
+		}
+
+		idx = iwl_txq_get_cmd_index(txq, txq->write_ptr);
+		/* the consumer must have cleared it before freeing it */
+		if (READ_ONCE(s->slots[idx]))
+			s->overruns++;
+		WRITE_ONCE(s->slots[idx], seq++);
+
+		iwl_txq_set_write_ptr(txq, iwl_txq_inc_wrap(s->trans,
+							    txq->write_ptr));
+	}
+
+	complete(&s->done[0]);
+	return 0;
+}
+
+/* mimics reclaim: consume the entries, then publish the read pointer */
+static int tx_spsc_consumer(void *data)
+{
+	struct tx_spsc *s = data;
+	struct iwl_txq *txq = s->txq;
+	u32 expected = 1;
+
+	while (expected <= TX_SPSC_FRAMES) {
+		int write_ptr = iwl_txq_get_write_ptr(txq);
+
+		if (txq->read_ptr == write_ptr) {
+			cond_resched();
+			continue;
+		}
+
+		while (txq->read_ptr != write_ptr) {
+			int idx = iwl_txq_get_cmd_index(txq, txq->read_ptr);
+
+			if (READ_ONCE(s->slots[idx]) != expected)
+				s->reordered++;
+			WRITE_ONCE(s->slots[idx], 0);
+			expected++;
+
+			iwl_txq_set_read_ptr(txq,
+					     iwl_txq_inc_wrap(s->trans,
+							      txq->read_ptr));
+		}
+	}
+
+	complete(&s->done[1]);
+	return 0;
+}
+
+static void tx_spsc_stress(struct kunit *test)
+{
+	struct task_struct *producer, *consumer;
+	struct tx_spsc *s;
+	int i;
+
+	s = kunit_kzalloc(test, sizeof(*s), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, s);
+	s->trans = kunit_kzalloc(test, sizeof(*s->trans), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, s->trans);
+	s->txq = kunit_kzalloc(test, sizeof(*s->txq), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, s->txq);
+	s->slots = kunit_kcalloc(test, TX_SPSC_WINDOW, sizeof(*s->slots),
+				 GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, s->slots);
+
+	s->trans->trans_cfg = &tx_spsc_trans_cfg;
+	s->txq->n_window = TX_SPSC_WINDOW;
+	for (i = 0; i < ARRAY_SIZE(s->done); i++)
+		init_completion(&s->done[i]);
+
+	KUNIT_EXPECT_EQ(test, iwl_txq_space(s->trans, s->txq), TX_SPSC_WINDOW);
+
+	consumer = kthread_run(tx_spsc_consumer, s, "iwl-spsc-cons");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(consumer));
+	producer = kthread_run(tx_spsc_producer, s, "iwl-spsc-prod");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(producer));
+
+	for (i = 0; i < ARRAY_SIZE(s->done); i++)
+		KUNIT_ASSERT_TRUE(test,
+				  wait_for_completion_timeout(&s->done[i],
+							      60 * HZ));
+
+	KUNIT_EXPECT_EQ(test, s->overruns, 0);
+	KUNIT_EXPECT_EQ(test, s->reordered, 0);
+	KUNIT_EXPECT_EQ(test, iwl_txq_space(s->trans, s->txq), TX_SPSC_WINDOW);
+	KUNIT_EXPECT_EQ(test, s->txq->read_ptr, s->txq->write_ptr);
+}
+
+static struct kunit_case tx_spsc_test_cases[] = {
+	KUNIT_CASE_SLOW(tx_spsc_stress),
+	{}
+};
+
+static struct kunit_suite tx_spsc_suite = {
+	.name = "iwlwifi-tx-spsc",
+	.test_cases = tx_spsc_test_cases,
+};
+
+kunit_test_suite(tx_spsc_suite);
@@ -5314,6 +5314,28 @@ void ieee80211_tx_status_skb(struct ieee80211_hw *hw,
 void ieee80211_tx_status_ext(struct ieee80211_hw *hw,
 			     struct ieee80211_tx_status *status);
 
+/**
+ * ieee80211_tx_status_list - transmit status callback for a batch of frames
+ *
+ * Reports the status of all the frames in @skbs, all transmitted to
+ * @pubsta, e.g. the frames acknowledged by one block ack. This is the
+ * same as calling ieee80211_tx_status_ext() for each of them, except
+ * that the pending airtime of the batch is released at once, and that
+ * frames of an A-MPDU that don't carry the A-MPDU status
+ * (%IEEE80211_TX_CTL_AMPDU without %IEEE80211_TX_STAT_AMPDU) aren't
+ * passed to rate control.
+ *
+ * The same restrictions as for ieee80211_tx_status_ext() apply, and it
+ * must be called under RCU.
+ *
+ * @hw: the hardware the frames were transmitted by
+ * @pubsta: the station the frames were transmitted to
+ * @skbs: the frames, owned by mac80211 after this call
+ */
+void ieee80211_tx_status_list(struct ieee80211_hw *hw,
+			      struct ieee80211_sta *pubsta,
+			      struct sk_buff_head *skbs);
+
 /**
  * ieee80211_tx_status_noskb - transmit status callback without skb
  *
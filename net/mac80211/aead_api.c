@@ -11,103 +11,157 @@
 #include <linux/types.h>
 #include <linux/err.h>
 #include <linux/scatterlist.h>
+#include <linux/percpu.h>
+#include <linux/bottom_half.h>
 #include <crypto/aead.h>
 
+#include "ieee80211_i.h"
 #include "aead_api.h"
 
-int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
-		 u8 *data, size_t data_len, u8 *mic)
+/*
+ * Set up this CPU's request for @aead, must be called with BHs disabled and
+ * the request used before enabling them again. The AAD is copied into the
+ * request since the caller's buffer may not be mappable (e.g. on the stack).
+ */
+static struct aead_request *
+aead_req_prepare(struct aead_key *aead, struct scatterlist *sg,
+		 u8 *aad, size_t aad_len, u8 *data, size_t data_len, u8 *mic)
 {
-	size_t mic_len = crypto_aead_authsize(tfm);
-	struct scatterlist sg[3];
-	struct aead_request *aead_req;
-	int reqsize = sizeof(*aead_req) + crypto_aead_reqsize(tfm);
-	u8 *__aad;
-	int ret;
-
-	aead_req = kzalloc(reqsize + aad_len, GFP_ATOMIC);
-	if (!aead_req)
-		return -ENOMEM;
+	struct aead_request *aead_req = *this_cpu_ptr(aead->req);
+	u8 *__aad = (u8 *)aead_req + aead->reqsize;
 
-	__aad = (u8 *)aead_req + reqsize;
 	memcpy(__aad, aad, aad_len);
 
 	sg_init_table(sg, 3);
 	sg_set_buf(&sg[0], __aad, aad_len);
 	sg_set_buf(&sg[1], data, data_len);
-	sg_set_buf(&sg[2], mic, mic_len);
+	sg_set_buf(&sg[2], mic, crypto_aead_authsize(aead->tfm));
 
-	aead_request_set_tfm(aead_req, tfm);
-	aead_request_set_crypt(aead_req, sg, sg, data_len, b_0);
-	aead_request_set_ad(aead_req, sg[0].length);
+	aead_request_set_tfm(aead_req, aead->tfm);
+	aead_request_set_callback(aead_req, 0, NULL, NULL);
+	aead_request_set_ad(aead_req, aad_len);
 
+	return aead_req;
+}
+
+int aead_encrypt(struct aead_key *aead, u8 *b_0, u8 *aad, size_t aad_len,
+		 u8 *data, size_t data_len, u8 *mic)
+{
+	struct scatterlist sg[3];
+	struct aead_request *aead_req;
+	int ret;
+
+	if (WARN_ON_ONCE(aad_len > AEAD_MAX_AAD_LEN))
+		return -EINVAL;
+
+	local_bh_disable();
+	aead_req = aead_req_prepare(aead, sg, aad, aad_len,
+				    data, data_len, mic);
+	aead_request_set_crypt(aead_req, sg, sg, data_len, b_0);
 	ret = crypto_aead_encrypt(aead_req);
-	kfree_sensitive(aead_req);
+	local_bh_enable();
 
 	return ret;
 }
+EXPORT_SYMBOL_IF_MAC80211_KUNIT(aead_encrypt);
 
-int aead_decrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
+int aead_decrypt(struct aead_key *aead, u8 *b_0, u8 *aad, size_t aad_len,
 		 u8 *data, size_t data_len, u8 *mic)
 {
-	size_t mic_len = crypto_aead_authsize(tfm);
+	size_t mic_len = crypto_aead_authsize(aead->tfm);
 	struct scatterlist sg[3];
 	struct aead_request *aead_req;
-	int reqsize = sizeof(*aead_req) + crypto_aead_reqsize(tfm);
-	u8 *__aad;
 	int err;
 
 	if (data_len == 0)
 		return -EINVAL;
 
-	aead_req = kzalloc(reqsize + aad_len, GFP_ATOMIC);
-	if (!aead_req)
-		return -ENOMEM;
-
-	__aad = (u8 *)aead_req + reqsize;
-	memcpy(__aad, aad, aad_len);
-
-	sg_init_table(sg, 3);
-	sg_set_buf(&sg[0], __aad, aad_len);
-	sg_set_buf(&sg[1], data, data_len);
-	sg_set_buf(&sg[2], mic, mic_len);
+	if (WARN_ON_ONCE(aad_len > AEAD_MAX_AAD_LEN))
+		return -EINVAL;
 
-	aead_request_set_tfm(aead_req, tfm);
+	local_bh_disable();
+	aead_req = aead_req_prepare(aead, sg, aad, aad_len,
+				    data, data_len, mic);
 	aead_request_set_crypt(aead_req, sg, sg, data_len + mic_len, b_0);
-	aead_request_set_ad(aead_req, sg[0].length);
-
 	err = crypto_aead_decrypt(aead_req);
-	kfree_sensitive(aead_req);
+	local_bh_enable();
 
 	return err;
 }
+EXPORT_SYMBOL_IF_MAC80211_KUNIT(aead_decrypt);
 
-struct crypto_aead *
+struct aead_key *
 aead_key_setup_encrypt(const char *alg, const u8 key[],
 		       size_t key_len, size_t mic_len)
 {
-	struct crypto_aead *tfm;
-	int err;
+	struct aead_key *aead;
+	int err, cpu;
+
+	aead = kzalloc(sizeof(*aead), GFP_KERNEL);
+	if (!aead)
+		return ERR_PTR(-ENOMEM);
 
-	tfm = crypto_alloc_aead(alg, 0, CRYPTO_ALG_ASYNC);
-	if (IS_ERR(tfm))
-		return tfm;
+	aead->tfm = crypto_alloc_aead(alg, 0, CRYPTO_ALG_ASYNC);
+	if (IS_ERR(aead->tfm)) {
+		err = PTR_ERR(aead->tfm);
+		goto free;
+	}
 
-	err = crypto_aead_setkey(tfm, key, key_len);
+	err = crypto_aead_setkey(aead->tfm, key, key_len);
 	if (err)
 		goto free_aead;
-	err = crypto_aead_setauthsize(tfm, mic_len);
+	err = crypto_aead_setauthsize(aead->tfm, mic_len);
 	if (err)
 		goto free_aead;
 
-	return tfm;
+	/*
+	 * The transform is synchronous, so a request is done with by the
+	 * time encrypt/decrypt returns and one per CPU is enough. The
+	 * requests themselves are kmalloc'ed since they're used in
+	 * scatterlists, which percpu memory can't be.
+	 */
+	aead->reqsize = sizeof(struct aead_request) +
+			crypto_aead_reqsize(aead->tfm);
+	aead->req = alloc_percpu(struct aead_request *);
+	if (!aead->req) {
+		err = -ENOMEM;
+		goto free_aead;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct aead_request *req;
+
+		req = kzalloc(aead->reqsize + AEAD_MAX_AAD_LEN, GFP_KERNEL);
+		if (!req) {
+			err = -ENOMEM;
+			goto free_reqs;
+		}
+		*per_cpu_ptr(aead->req, cpu) = req;
+	}
+
+	return aead;
 
+free_reqs:
+	for_each_possible_cpu(cpu)
+		kfree(*per_cpu_ptr(aead->req, cpu));
+	free_percpu(aead->req);
 free_aead:
-	crypto_free_aead(tfm);
+	crypto_free_aead(aead->tfm);
+free:
+	kfree(aead);
 	return ERR_PTR(err);
 }
+EXPORT_SYMBOL_IF_MAC80211_KUNIT(aead_key_setup_encrypt);
 
-void aead_key_free(struct crypto_aead *tfm)
+void aead_key_free(struct aead_key *aead)
 {
-	crypto_free_aead(tfm);
+	int cpu;
+
+	/* the requests may still hold intermediate state of the last frame */
+	for_each_possible_cpu(cpu)
+		kfree_sensitive(*per_cpu_ptr(aead->req, cpu));
+	free_percpu(aead->req);
+	crypto_free_aead(aead->tfm);
+	kfree(aead);
 }
+EXPORT_SYMBOL_IF_MAC80211_KUNIT(aead_key_free);
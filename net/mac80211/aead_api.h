@@ -6,18 +6,35 @@
 #include <crypto/aead.h>
 #include <linux/crypto.h>
 
-struct crypto_aead *
+/* both CCMP and GCMP use at most 30 bytes of AAD */
+#define AEAD_MAX_AAD_LEN	32
+
+/**
+ * struct aead_key - AEAD transform with preallocated requests
+ *
+ * @tfm: the transform, holding the key
+ * @req: per-CPU pointer to a request, followed by %AEAD_MAX_AAD_LEN
+ *	bytes for the AAD
+ * @reqsize: size of each request, including the transform's context
+ */
+struct aead_key {
+	struct crypto_aead *tfm;
+	struct aead_request * __percpu *req;
+	unsigned int reqsize;
+};
+
+struct aead_key *
 aead_key_setup_encrypt(const char *alg, const u8 key[],
 		       size_t key_len, size_t mic_len);
 
-int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad,
+int aead_encrypt(struct aead_key *aead, u8 *b_0, u8 *aad,
 		 size_t aad_len, u8 *data,
 		 size_t data_len, u8 *mic);
 
-int aead_decrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad,
+int aead_decrypt(struct aead_key *aead, u8 *b_0, u8 *aad,
 		 size_t aad_len, u8 *data,
 		 size_t data_len, u8 *mic);
 
-void aead_key_free(struct crypto_aead *tfm);
+void aead_key_free(struct aead_key *aead);
 
 #endif /* _AEAD_API_H */
@@ -10,34 +10,34 @@
 
 #define GCM_AAD_LEN	32
 
-static inline int ieee80211_aes_gcm_encrypt(struct crypto_aead *tfm,
+static inline int ieee80211_aes_gcm_encrypt(struct aead_key *aead,
 					    u8 *j_0, u8 *aad,  u8 *data,
 					    size_t data_len, u8 *mic)
 {
-	return aead_encrypt(tfm, j_0, aad + 2,
+	return aead_encrypt(aead, j_0, aad + 2,
 			    be16_to_cpup((__be16 *)aad),
 			    data, data_len, mic);
 }
 
-static inline int ieee80211_aes_gcm_decrypt(struct crypto_aead *tfm,
+static inline int ieee80211_aes_gcm_decrypt(struct aead_key *aead,
 					    u8 *j_0, u8 *aad, u8 *data,
 					    size_t data_len, u8 *mic)
 {
-	return aead_decrypt(tfm, j_0, aad + 2,
+	return aead_decrypt(aead, j_0, aad + 2,
 			    be16_to_cpup((__be16 *)aad),
 			    data, data_len, mic);
 }
 
-static inline struct crypto_aead *
+static inline struct aead_key *
 ieee80211_aes_gcm_key_setup_encrypt(const u8 key[], size_t key_len)
 {
 	return aead_key_setup_encrypt("gcm(aes)", key,
 				      key_len, IEEE80211_GCMP_MIC_LEN);
 }
 
-static inline void ieee80211_aes_gcm_key_free(struct crypto_aead *tfm)
+static inline void ieee80211_aes_gcm_key_free(struct aead_key *aead)
 {
-	return aead_key_free(tfm);
+	return aead_key_free(aead);
 }
 
 #endif /* AES_GCM_H */
@@ -201,6 +201,62 @@ static const struct file_operations airtime_flags_ops = {
 	.llseek = default_llseek,
 };
 
+static const char * const airtime_sched_names[] = {
+	[IEEE80211_AIRTIME_SCHED_DRR] = "drr",
+	[IEEE80211_AIRTIME_SCHED_VT] = "vt",
+};
+
+static ssize_t airtime_sched_read(struct file *file,
+				  char __user *user_buf,
+				  size_t count, loff_t *ppos)
+{
+	struct ieee80211_local *local = file->private_data;
+	char buf[16];
+	int len;
+
+	/* all ACs are switched together */
+	len = scnprintf(buf, sizeof(buf), "%s\n",
+			airtime_sched_names[local->airtime_sched[0]]);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
+}
+
+static ssize_t airtime_sched_write(struct file *file,
+				   const char __user *user_buf,
+				   size_t count, loff_t *ppos)
+{
+	struct ieee80211_local *local = file->private_data;
+	char buf[16];
+	int sched;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(buf, user_buf, count))
+		return -EFAULT;
+
+	if (count && buf[count - 1] == '\n')
+		buf[count - 1] = '\0';
+	else
+		buf[count] = '\0';
+
+	sched = match_string(airtime_sched_names,
+			     ARRAY_SIZE(airtime_sched_names), buf);
+	if (sched < 0)
+		return -EINVAL;
+
+	ieee80211_set_airtime_sched(local, sched);
+
+	return count;
+}
+
+static const struct file_operations airtime_sched_ops = {
+	.write = airtime_sched_write,
+	.read = airtime_sched_read,
+	.open = simple_open,
+	.llseek = default_llseek,
+};
+
 static ssize_t aql_pending_read(struct file *file,
 				char __user *user_buf,
 				size_t count, loff_t *ppos)
@@ -676,6 +732,7 @@ void debugfs_hw_add(struct ieee80211_local *local)
 	DEBUGFS_ADD_MODE(aqm, 0600);
 
 	DEBUGFS_ADD_MODE(airtime_flags, 0600);
+	DEBUGFS_ADD_MODE(airtime_sched, 0600);
 
 	DEBUGFS_ADD(aql_txq_limit);
 	debugfs_create_u32("aql_threshold", 0600,
@@ -204,6 +204,7 @@ static ssize_t sta_airtime_read(struct file *file, char __user *userbuf,
 	char *buf = kzalloc(bufsz, GFP_KERNEL), *p = buf;
 	u64 rx_airtime = 0, tx_airtime = 0;
 	s32 deficit[IEEE80211_NUM_ACS];
+	u64 v_t[IEEE80211_NUM_ACS];
 	ssize_t rv;
 	int ac;
 
@@ -215,14 +216,17 @@ static ssize_t sta_airtime_read(struct file *file, char __user *userbuf,
 		rx_airtime += sta->airtime[ac].rx_airtime;
 		tx_airtime += sta->airtime[ac].tx_airtime;
 		deficit[ac] = sta->airtime[ac].deficit;
+		v_t[ac] = sta->airtime[ac].v_t;
 		spin_unlock_bh(&local->active_txq_lock[ac]);
 	}
 
 	p += scnprintf(p, bufsz + buf - p,
 		"RX: %llu us\nTX: %llu us\nWeight: %u\n"
-		"Deficit: VO: %d us VI: %d us BE: %d us BK: %d us\n",
+		"Deficit: VO: %d us VI: %d us BE: %d us BK: %d us\n"
+		"Virtual time: VO: %llu VI: %llu BE: %llu BK: %llu\n",
 		rx_airtime, tx_airtime, sta->airtime_weight,
-		deficit[0], deficit[1], deficit[2], deficit[3]);
+		deficit[0], deficit[1], deficit[2], deficit[3],
+		v_t[0], v_t[1], v_t[2], v_t[3]);
 
 	rv = simple_read_from_buffer(userbuf, count, ppos, buf, p - buf);
 	kfree(buf);
@@ -241,6 +245,7 @@ static ssize_t sta_airtime_write(struct file *file, const char __user *userbuf,
 		sta->airtime[ac].rx_airtime = 0;
 		sta->airtime[ac].tx_airtime = 0;
 		sta->airtime[ac].deficit = sta->airtime_weight;
+		sta->airtime[ac].v_t = 0;
 		spin_unlock_bh(&local->active_txq_lock[ac]);
 	}
 
@@ -1231,6 +1236,43 @@ out:
 }
 LINK_STA_OPS(eht_capa);
 
+static ssize_t link_sta_rx_fragments_do_read(struct wiphy *wiphy,
+					     struct file *file, char *buf,
+					     size_t bufsz, void *data)
+{
+	struct link_sta_info *link_sta = data;
+	struct sta_info *sta = link_sta->sta;
+	u64 fragments;
+	int cpu;
+
+	/* the fast-RX path counts into the per-CPU stats */
+	if (link_sta == &sta->deflink) {
+		fragments = sta_get_rx_stats_snapshot(sta)->fragments;
+	} else {
+		fragments = link_sta->rx_stats.fragments;
+		for_each_possible_cpu(cpu)
+			fragments += per_cpu_ptr(link_sta->pcpu_rx_stats,
+						 cpu)->fragments;
+	}
+
+	return scnprintf(buf, bufsz, "%llu\n", fragments);
+}
+
+static ssize_t link_sta_rx_fragments_read(struct file *file,
+					  char __user *userbuf,
+					  size_t count, loff_t *ppos)
+{
+	struct link_sta_info *link_sta = file->private_data;
+	struct wiphy *wiphy = link_sta->sta->local->hw.wiphy;
+	char buf[24];
+
+	return wiphy_locked_debugfs_read(wiphy, file, buf, sizeof(buf),
+					 userbuf, count, ppos,
+					 link_sta_rx_fragments_do_read,
+					 link_sta);
+}
+LINK_STA_OPS(rx_fragments);
+
 #define DEBUGFS_ADD(name) \
 	debugfs_create_file(#name, 0400, \
 		sta->debugfs_dir, sta, &sta_ ##name## _ops)
@@ -1327,7 +1369,7 @@ void ieee80211_link_sta_debugfs_add(struct link_sta_info *link_sta)
 	DEBUGFS_ADD(eht_capa);
 
 	DEBUGFS_ADD_COUNTER(rx_duplicates, rx_stats.num_duplicates);
-	DEBUGFS_ADD_COUNTER(rx_fragments, rx_stats.fragments);
+	DEBUGFS_ADD(rx_fragments);
 }
 
 void ieee80211_link_sta_debugfs_remove(struct link_sta_info *link_sta)
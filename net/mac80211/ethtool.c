@@ -96,19 +96,22 @@ static void ieee80211_get_stats(struct net_device *dev,
 
 	memset(data, 0, sizeof(u64) * STA_STATS_LEN);
 
-#define ADD_STA_STATS(sta)					\
-	do {							\
-		data[i++] += sinfo.rx_packets;			\
-		data[i++] += sinfo.rx_bytes;			\
-		data[i++] += (sta)->rx_stats.num_duplicates;	\
-		data[i++] += (sta)->rx_stats.fragments;		\
-		data[i++] += sinfo.rx_dropped_misc;		\
-								\
-		data[i++] += sinfo.tx_packets;			\
-		data[i++] += sinfo.tx_bytes;			\
-		data[i++] += (sta)->status_stats.filtered;	\
-		data[i++] += sinfo.tx_failed;			\
-		data[i++] += sinfo.tx_retries;			\
+#define ADD_STA_STATS(sta)						\
+	do {								\
+		const struct ieee80211_sta_rx_stats_snapshot *snap =	\
+			sta_get_rx_stats_snapshot(sta);			\
+									\
+		data[i++] += sinfo.rx_packets;				\
+		data[i++] += sinfo.rx_bytes;				\
+		data[i++] += snap->num_duplicates;			\
+		data[i++] += snap->fragments;				\
+		data[i++] += sinfo.rx_dropped_misc;			\
+									\
+		data[i++] += sinfo.tx_packets;				\
+		data[i++] += sinfo.tx_bytes;				\
+		data[i++] += (sta)->deflink.status_stats.filtered;	\
+		data[i++] += sinfo.tx_failed;				\
+		data[i++] += sinfo.tx_retries;				\
 	} while (0)
 
 	/* For Managed stations, find the single station based on BSSID
@@ -129,7 +132,7 @@ static void ieee80211_get_stats(struct net_device *dev,
 		sta_set_sinfo(sta, &sinfo, false);
 
 		i = 0;
-		ADD_STA_STATS(&sta->deflink);
+		ADD_STA_STATS(sta);
 
 		data[i++] = sta->sta_state;
 
@@ -155,7 +158,7 @@ static void ieee80211_get_stats(struct net_device *dev,
 			memset(&sinfo, 0, sizeof(sinfo));
 			sta_set_sinfo(sta, &sinfo, false);
 			i = 0;
-			ADD_STA_STATS(&sta->deflink);
+			ADD_STA_STATS(sta);
 		}
 	}
 
@@ -98,6 +98,12 @@ enum ieee80211_status_data {
  */
 #define AIRTIME_ACTIVE_DURATION (HZ / 10)
 
+/*
+ * Fixed point shift for the virtual time scheduler, a station's virtual time
+ * advances by (airtime << AIRTIME_VT_SHIFT) / airtime_weight
+ */
+#define AIRTIME_VT_SHIFT 8
+
 struct ieee80211_bss {
 	u32 device_ts_beacon, device_ts_presp;
 
@@ -910,6 +916,8 @@ enum txq_info_flags {
  * @cstats: code statistics for this queue
  * @frags: used to keep fragments created after dequeue
  * @schedule_order: used with ieee80211_local->active_txqs
+ * @schedule_node: used with ieee80211_local->active_txq_tree
+ * @schedule_vt: virtual time @schedule_node is sorted by
  * @schedule_round: counter to prevent infinite loops on TXQ scheduling
  * @flags: TXQ flags from &enum txq_info_flags
  * @txq: the driver visible part
@@ -921,6 +929,8 @@ struct txq_info {
 
 	u16 schedule_round;
 	struct list_head schedule_order;
+	struct rb_node schedule_node;
+	u64 schedule_vt;
 
 	struct sk_buff_head frags;
 
@@ -1317,6 +1327,19 @@ enum mac80211_scan_state {
 DECLARE_STATIC_KEY_FALSE(aql_disable);
 #endif
 
+/**
+ * enum ieee80211_airtime_sched - airtime fairness TXQ scheduler
+ *
+ * @IEEE80211_AIRTIME_SCHED_DRR: deficit round robin over the
+ *	ieee80211_local->active_txqs list
+ * @IEEE80211_AIRTIME_SCHED_VT: weighted virtual time order, kept in the
+ *	ieee80211_local->active_txq_tree rbtree
+ */
+enum ieee80211_airtime_sched {
+	IEEE80211_AIRTIME_SCHED_DRR,
+	IEEE80211_AIRTIME_SCHED_VT,
+};
+
 struct ieee80211_local {
 	/* embed the driver visible part.
 	 * don't cast (use the static inlines below), but we keep
@@ -1327,9 +1350,17 @@ struct ieee80211_local {
 	struct codel_vars *cvars;
 	struct codel_params cparams;
 
-	/* protects active_txqs and txqi->schedule_order */
+	/*
+	 * protects active_txqs, active_txq_tree and the txqi->schedule_*
+	 * fields; only one of active_txqs and active_txq_tree is in use for
+	 * an AC, depending on airtime_sched
+	 */
 	spinlock_t active_txq_lock[IEEE80211_NUM_ACS];
 	struct list_head active_txqs[IEEE80211_NUM_ACS];
+	struct rb_root_cached active_txq_tree[IEEE80211_NUM_ACS];
+	u32 active_txq_tree_len[IEEE80211_NUM_ACS];
+	u64 airtime_v_t[IEEE80211_NUM_ACS];
+	u8 airtime_sched[IEEE80211_NUM_ACS];
 	u16 schedule_round[IEEE80211_NUM_ACS];
 
 	/* serializes ieee80211_handle_wake_tx_queue */
@@ -2277,6 +2308,37 @@ static inline void ieee80211_tx_skb(struct ieee80211_sub_if_data *sdata,
 	ieee80211_tx_skb_tid(sdata, skb, 7, -1);
 }
 
+/**
+ * enum ieee80211_elems_class - classes of elements to parse
+ *
+ * Used as bits in &struct ieee80211_elems_parse_params.classes to parse
+ * only the elements a caller is interested in.
+ *
+ * @IEEE80211_ELEMS_BASIC: SSID, rates, ERP, RSN, country and other
+ *	basic BSS elements
+ * @IEEE80211_ELEMS_TIM: the TIM element
+ * @IEEE80211_ELEMS_WMM: WMM (vendor specific) elements
+ * @IEEE80211_ELEMS_HT: HT elements
+ * @IEEE80211_ELEMS_VHT: VHT elements
+ * @IEEE80211_ELEMS_HE: HE elements
+ * @IEEE80211_ELEMS_EHT: EHT elements, including the multi-link element
+ * @IEEE80211_ELEMS_CSA: channel switch related elements
+ * @IEEE80211_ELEMS_MESH: mesh elements
+ * @IEEE80211_ELEMS_S1G: S1G elements
+ */
+enum ieee80211_elems_class {
+	IEEE80211_ELEMS_BASIC,
+	IEEE80211_ELEMS_TIM,
+	IEEE80211_ELEMS_WMM,
+	IEEE80211_ELEMS_HT,
+	IEEE80211_ELEMS_VHT,
+	IEEE80211_ELEMS_HE,
+	IEEE80211_ELEMS_EHT,
+	IEEE80211_ELEMS_CSA,
+	IEEE80211_ELEMS_MESH,
+	IEEE80211_ELEMS_S1G,
+};
+
 /**
  * struct ieee80211_elems_parse_params - element parsing parameters
  * @mode: connection mode for parsing
@@ -2295,6 +2357,9 @@ static inline void ieee80211_tx_skb(struct ieee80211_sub_if_data *sdata,
  *	(or re-association) response frame if this is given
  * @from_ap: frame is received from an AP (currently used only
  *	for EHT capabilities parsing)
+ * @classes: bitmap of &enum ieee80211_elems_class to parse, or 0 to
+ *	parse all elements; other elements are skipped without being
+ *	validated unless they're needed for the CRC
  */
 struct ieee80211_elems_parse_params {
 	enum ieee80211_conn_mode mode;
@@ -2306,6 +2371,7 @@ struct ieee80211_elems_parse_params {
 	struct cfg80211_bss *bss;
 	int link_id;
 	bool from_ap;
+	u32 classes;
 };
 
 struct ieee802_11_elems *
@@ -2431,6 +2497,10 @@ void ieee80211_txq_init(struct ieee80211_sub_if_data *sdata,
 			struct txq_info *txq, int tid);
 void ieee80211_txq_purge(struct ieee80211_local *local,
 			 struct txq_info *txqi);
+void ieee80211_txq_unschedule(struct ieee80211_local *local,
+			      struct txq_info *txqi);
+void ieee80211_set_airtime_sched(struct ieee80211_local *local,
+				 enum ieee80211_airtime_sched sched);
 void ieee80211_purge_sta_txqs(struct sta_info *sta);
 void ieee80211_txq_remove_vlan(struct ieee80211_local *local,
 			       struct ieee80211_sub_if_data *sdata);
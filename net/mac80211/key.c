@@ -643,10 +643,10 @@ ieee80211_key_alloc(u32 cipher, int idx, size_t key_len,
 		 * Initialize AES key state here as an optimization so that
 		 * it does not need to be initialized for every packet.
 		 */
-		key->u.ccmp.tfm = ieee80211_aes_key_setup_encrypt(
+		key->u.ccmp.aead = ieee80211_aes_key_setup_encrypt(
 			key_data, key_len, IEEE80211_CCMP_MIC_LEN);
-		if (IS_ERR(key->u.ccmp.tfm)) {
-			err = PTR_ERR(key->u.ccmp.tfm);
+		if (IS_ERR(key->u.ccmp.aead)) {
+			err = PTR_ERR(key->u.ccmp.aead);
 			kfree(key);
 			return ERR_PTR(err);
 		}
@@ -661,10 +661,10 @@ ieee80211_key_alloc(u32 cipher, int idx, size_t key_len,
 		/* Initialize AES key state here as an optimization so that
 		 * it does not need to be initialized for every packet.
 		 */
-		key->u.ccmp.tfm = ieee80211_aes_key_setup_encrypt(
+		key->u.ccmp.aead = ieee80211_aes_key_setup_encrypt(
 			key_data, key_len, IEEE80211_CCMP_256_MIC_LEN);
-		if (IS_ERR(key->u.ccmp.tfm)) {
-			err = PTR_ERR(key->u.ccmp.tfm);
+		if (IS_ERR(key->u.ccmp.aead)) {
+			err = PTR_ERR(key->u.ccmp.aead);
 			kfree(key);
 			return ERR_PTR(err);
 		}
@@ -722,10 +722,10 @@ ieee80211_key_alloc(u32 cipher, int idx, size_t key_len,
 		/* Initialize AES key state here as an optimization so that
 		 * it does not need to be initialized for every packet.
 		 */
-		key->u.gcmp.tfm = ieee80211_aes_gcm_key_setup_encrypt(key_data,
-								      key_len);
-		if (IS_ERR(key->u.gcmp.tfm)) {
-			err = PTR_ERR(key->u.gcmp.tfm);
+		key->u.gcmp.aead = ieee80211_aes_gcm_key_setup_encrypt(key_data,
+								       key_len);
+		if (IS_ERR(key->u.gcmp.aead)) {
+			err = PTR_ERR(key->u.gcmp.aead);
 			kfree(key);
 			return ERR_PTR(err);
 		}
@@ -742,7 +742,7 @@ static void ieee80211_key_free_common(struct ieee80211_key *key)
 	switch (key->conf.cipher) {
 	case WLAN_CIPHER_SUITE_CCMP:
 	case WLAN_CIPHER_SUITE_CCMP_256:
-		ieee80211_aes_key_free(key->u.ccmp.tfm);
+		ieee80211_aes_key_free(key->u.ccmp.aead);
 		break;
 	case WLAN_CIPHER_SUITE_AES_CMAC:
 	case WLAN_CIPHER_SUITE_BIP_CMAC_256:
@@ -754,7 +754,7 @@ static void ieee80211_key_free_common(struct ieee80211_key *key)
 		break;
 	case WLAN_CIPHER_SUITE_GCMP:
 	case WLAN_CIPHER_SUITE_GCMP_256:
-		ieee80211_aes_gcm_key_free(key->u.gcmp.tfm);
+		ieee80211_aes_gcm_key_free(key->u.gcmp.aead);
 		break;
 	}
 	kfree_sensitive(key);
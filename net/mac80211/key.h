@@ -24,6 +24,7 @@ struct ieee80211_local;
 struct ieee80211_sub_if_data;
 struct ieee80211_link_data;
 struct sta_info;
+struct aead_key;
 
 /**
  * enum ieee80211_internal_key_flags - internal key flags
@@ -88,7 +89,7 @@ struct ieee80211_key {
 			 * Management frames.
 			 */
 			u8 rx_pn[IEEE80211_NUM_TIDS + 1][IEEE80211_CCMP_PN_LEN];
-			struct crypto_aead *tfm;
+			struct aead_key *aead;
 			u32 replays; /* dot11RSNAStatsCCMPReplays */
 		} ccmp;
 		struct {
@@ -110,7 +111,7 @@ struct ieee80211_key {
 			 * Management frames.
 			 */
 			u8 rx_pn[IEEE80211_NUM_TIDS + 1][IEEE80211_GCMP_PN_LEN];
-			struct crypto_aead *tfm;
+			struct aead_key *aead;
 			u32 replays; /* dot11RSNAStatsGCMPReplays */
 		} gcmp;
 		struct {
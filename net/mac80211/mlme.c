@@ -6435,6 +6435,11 @@ static void ieee80211_rx_mgmt_beacon(struct ieee80211_link_data *link,
 	parse_params.bss = link->u.mgd.bss;
 	parse_params.filter = care_about_ies;
 	parse_params.crc = ncrc;
+	/*
+	 * Most beacons are unchanged, so until the CRC says otherwise only
+	 * the TIM is needed and the rest is known from an earlier beacon.
+	 */
+	parse_params.classes = BIT(IEEE80211_ELEMS_TIM);
 	elems = ieee802_11_parse_elems_full(&parse_params);
 	if (!elems)
 		return;
@@ -6517,6 +6522,14 @@ static void ieee80211_rx_mgmt_beacon(struct ieee80211_link_data *link,
 	if ((ncrc == link->u.mgd.beacon_crc && link->u.mgd.beacon_crc_valid) ||
 	    ieee80211_is_s1g_short_beacon(mgmt->frame_control))
 		goto free;
+
+	kfree(elems);
+	parse_params.filter = 0;
+	parse_params.classes = 0;
+	elems = ieee802_11_parse_elems_full(&parse_params);
+	if (!elems)
+		return;
+
 	link->u.mgd.beacon_crc = ncrc;
 	link->u.mgd.beacon_crc_valid = true;
 
@@ -7453,9 +7466,7 @@ static void ieee80211_sta_conn_mon_timer(struct timer_list *t)
 	if (!sta)
 		return;
 
-	timeout = sta->deflink.status_stats.last_ack;
-	if (time_before(sta->deflink.status_stats.last_ack, sta->deflink.rx_stats.last_rx))
-		timeout = sta->deflink.rx_stats.last_rx;
+	timeout = ieee80211_sta_last_active(sta);
 	timeout += IEEE80211_CONNECTION_IDLE_TIME;
 
 	/* If timeout is after now, then update timer to fire at
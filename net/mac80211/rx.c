@@ -1569,8 +1569,7 @@ static void sta_ps_start(struct sta_info *sta)
 		struct txq_info *txqi = to_txq_info(txq);
 
 		spin_lock(&local->active_txq_lock[txq->ac]);
-		if (!list_empty(&txqi->schedule_order))
-			list_del_init(&txqi->schedule_order);
+		ieee80211_txq_unschedule(local, txqi);
 		spin_unlock(&local->active_txq_lock[txq->ac]);
 
 		if (txq_has_queue(txq))
@@ -4762,9 +4761,7 @@ static void ieee80211_rx_8023(struct ieee80211_rx_data *rx,
 		link_sta = &sta->deflink;
 	}
 
-	stats = &link_sta->rx_stats;
-	if (fast_rx->uses_rss)
-		stats = this_cpu_ptr(link_sta->pcpu_rx_stats);
+	stats = this_cpu_ptr(link_sta->pcpu_rx_stats);
 
 	/* statistics part of ieee80211_rx_h_sta_process() */
 	if (!(status->flag & RX_FLAG_NO_SIGNAL_VAL)) {
@@ -4981,11 +4978,7 @@ static bool ieee80211_invoke_fast_rx(struct ieee80211_rx_data *rx,
  drop:
 	dev_kfree_skb(skb);
 
-	if (fast_rx->uses_rss)
-		stats = this_cpu_ptr(rx->link_sta->pcpu_rx_stats);
-	else
-		stats = &rx->link_sta->rx_stats;
-
+	stats = this_cpu_ptr(rx->link_sta->pcpu_rx_stats);
 	stats->dropped++;
 	return true;
 }
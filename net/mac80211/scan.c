@@ -68,6 +68,16 @@ void ieee80211_inform_bss(struct wiphy *wiphy,
 	struct ieee80211_local *local = wiphy_priv(wiphy);
 	struct inform_bss_update_data *update_data = data;
 	struct ieee80211_bss *bss = (void *)cbss->priv;
+	struct ieee80211_elems_parse_params parse_params = {
+		.mode = IEEE80211_CONN_MODE_HIGHEST,
+		.start = ies->data,
+		.len = ies->len,
+		.link_id = -1,
+		/* only what's kept in struct ieee80211_bss below */
+		.classes = BIT(IEEE80211_ELEMS_BASIC) |
+			   BIT(IEEE80211_ELEMS_WMM) |
+			   BIT(IEEE80211_ELEMS_VHT),
+	};
 	struct ieee80211_rx_status *rx_status;
 	struct ieee802_11_elems *elems;
 	int clen, srlen;
@@ -76,7 +86,7 @@ void ieee80211_inform_bss(struct wiphy *wiphy,
 	if (!update_data)
 		return;
 
-	elems = ieee802_11_parse_elems(ies->data, ies->len, false, NULL);
+	elems = ieee802_11_parse_elems_full(&parse_params);
 	if (!elems)
 		return;
 
@@ -491,15 +491,12 @@ static int sta_info_alloc_link(struct ieee80211_local *local,
 			       struct link_sta_info *link_info,
 			       gfp_t gfp)
 {
-	struct ieee80211_hw *hw = &local->hw;
 	int i;
 
-	if (ieee80211_hw_check(hw, USES_RSS)) {
-		link_info->pcpu_rx_stats =
-			alloc_percpu_gfp(struct ieee80211_sta_rx_stats, gfp);
-		if (!link_info->pcpu_rx_stats)
-			return -ENOMEM;
-	}
+	link_info->pcpu_rx_stats =
+		alloc_percpu_gfp(struct ieee80211_sta_rx_stats, gfp);
+	if (!link_info->pcpu_rx_stats)
+		return -ENOMEM;
 
 	link_info->rx_stats.last_rx = jiffies;
 	u64_stats_init(&link_info->rx_stats.syncp);
@@ -1466,6 +1463,8 @@ static void __sta_info_destroy_part2(struct sta_info *sta, bool recalc)
 
 	sta_dbg(sdata, "Removed STA %pM\n", sta->sta.addr);
 
+	/* the final statistics shouldn't come from an old snapshot */
+	sta->deflink.rx_stats_snapshot.valid = false;
 	sinfo = kzalloc(sizeof(*sinfo), GFP_KERNEL);
 	if (sinfo)
 		sta_set_sinfo(sta, sinfo, true);
@@ -2284,8 +2283,12 @@ void ieee80211_sta_register_airtime(struct ieee80211_sta *pubsta, u8 tid,
 	sta->airtime[ac].rx_airtime += rx_airtime;
 
 	diff = (u32)jiffies - sta->airtime[ac].last_active;
-	if (diff <= AIRTIME_ACTIVE_DURATION)
+	if (diff <= AIRTIME_ACTIVE_DURATION) {
 		sta->airtime[ac].deficit -= airtime;
+		sta->airtime[ac].v_t +=
+			div_u64((u64)airtime << AIRTIME_VT_SHIFT,
+				sta->airtime_weight);
+	}
 
 	spin_unlock_bh(&local->active_txq_lock[ac]);
 }
@@ -2346,7 +2349,7 @@ EXPORT_SYMBOL(ieee80211_sta_recalc_aggregates);
 
 void ieee80211_sta_update_pending_airtime(struct ieee80211_local *local,
 					  struct sta_info *sta, u8 ac,
-					  u16 tx_airtime, bool tx_completed)
+					  u32 tx_airtime, bool tx_completed)
 {
 	int tx_pending;
 
@@ -2390,9 +2393,6 @@ sta_get_last_rx_stats(struct sta_info *sta)
 	struct ieee80211_sta_rx_stats *stats = &sta->deflink.rx_stats;
 	int cpu;
 
-	if (!sta->deflink.pcpu_rx_stats)
-		return stats;
-
 	for_each_possible_cpu(cpu) {
 		struct ieee80211_sta_rx_stats *cpustats;
 
@@ -2475,42 +2475,73 @@ static int sta_set_rate_info_rx(struct sta_info *sta, struct rate_info *rinfo)
 	return 0;
 }
 
-static inline u64 sta_get_tidstats_msdu(struct ieee80211_sta_rx_stats *rxstats,
-					int tid)
+static void
+sta_rx_stats_snapshot_add(struct ieee80211_sta_rx_stats_snapshot *snap,
+			  struct ieee80211_sta_rx_stats *rxstats)
 {
+	u64 msdu[ARRAY_SIZE(rxstats->msdu)];
 	unsigned int start;
-	u64 value;
+	u64 bytes;
+	int tid;
+
+	snap->packets += rxstats->packets;
+	snap->num_duplicates += rxstats->num_duplicates;
+	snap->fragments += rxstats->fragments;
+	snap->dropped += rxstats->dropped;
 
 	do {
 		start = u64_stats_fetch_begin(&rxstats->syncp);
-		value = rxstats->msdu[tid];
+		bytes = rxstats->bytes;
+		memcpy(msdu, rxstats->msdu, sizeof(msdu));
 	} while (u64_stats_fetch_retry(&rxstats->syncp, start));
 
-	return value;
+	snap->bytes += bytes;
+	for (tid = 0; tid < ARRAY_SIZE(msdu); tid++)
+		snap->msdu[tid] += msdu[tid];
+}
+
+/*
+ * Get the RX counters of the station summed up over all CPUs, this is
+ * refreshed at most every STA_RX_STATS_SNAPSHOT_INTERVAL unless the
+ * snapshot was invalidated.
+ */
+const struct ieee80211_sta_rx_stats_snapshot *
+sta_get_rx_stats_snapshot(struct sta_info *sta)
+{
+	struct link_sta_info *link_sta = &sta->deflink;
+	struct ieee80211_sta_rx_stats_snapshot *snap =
+		&link_sta->rx_stats_snapshot;
+	int cpu;
+
+	lockdep_assert_wiphy(sta->local->hw.wiphy);
+
+	if (snap->valid &&
+	    time_before(jiffies,
+			snap->updated + STA_RX_STATS_SNAPSHOT_INTERVAL))
+		return snap;
+
+	memset(snap, 0, sizeof(*snap));
+	sta_rx_stats_snapshot_add(snap, &link_sta->rx_stats);
+	for_each_possible_cpu(cpu)
+		sta_rx_stats_snapshot_add(snap,
+					  per_cpu_ptr(link_sta->pcpu_rx_stats,
+						      cpu));
+
+	snap->updated = jiffies;
+	snap->valid = true;
+
+	return snap;
 }
 
 static void sta_set_tidstats(struct sta_info *sta,
+			     const struct ieee80211_sta_rx_stats_snapshot *snap,
 			     struct cfg80211_tid_stats *tidstats,
 			     int tid)
 {
 	struct ieee80211_local *local = sta->local;
-	int cpu;
 
 	if (!(tidstats->filled & BIT(NL80211_TID_STATS_RX_MSDU))) {
-		tidstats->rx_msdu += sta_get_tidstats_msdu(&sta->deflink.rx_stats,
-							   tid);
-
-		if (sta->deflink.pcpu_rx_stats) {
-			for_each_possible_cpu(cpu) {
-				struct ieee80211_sta_rx_stats *cpurxs;
-
-				cpurxs = per_cpu_ptr(sta->deflink.pcpu_rx_stats,
-						     cpu);
-				tidstats->rx_msdu +=
-					sta_get_tidstats_msdu(cpurxs, tid);
-			}
-		}
-
+		tidstats->rx_msdu += snap->msdu[tid];
 		tidstats->filled |= BIT(NL80211_TID_STATS_RX_MSDU);
 	}
 
@@ -2544,29 +2575,18 @@ static void sta_set_tidstats(struct sta_info *sta,
 	}
 }
 
-static inline u64 sta_get_stats_bytes(struct ieee80211_sta_rx_stats *rxstats)
-{
-	unsigned int start;
-	u64 value;
-
-	do {
-		start = u64_stats_fetch_begin(&rxstats->syncp);
-		value = rxstats->bytes;
-	} while (u64_stats_fetch_retry(&rxstats->syncp, start));
-
-	return value;
-}
-
 void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 		   bool tidstats)
 {
 	struct ieee80211_sub_if_data *sdata = sta->sdata;
 	struct ieee80211_local *local = sdata->local;
 	u32 thr = 0;
-	int i, ac, cpu;
+	int i, ac;
 	struct ieee80211_sta_rx_stats *last_rxstats;
+	const struct ieee80211_sta_rx_stats_snapshot *snap;
 
 	last_rxstats = sta_get_last_rx_stats(sta);
+	snap = sta_get_rx_stats_snapshot(sta);
 
 	sinfo->generation = sdata->local->sta_generation;
 
@@ -2613,32 +2633,12 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 
 	if (!(sinfo->filled & (BIT_ULL(NL80211_STA_INFO_RX_BYTES64) |
 			       BIT_ULL(NL80211_STA_INFO_RX_BYTES)))) {
-		sinfo->rx_bytes += sta_get_stats_bytes(&sta->deflink.rx_stats);
-
-		if (sta->deflink.pcpu_rx_stats) {
-			for_each_possible_cpu(cpu) {
-				struct ieee80211_sta_rx_stats *cpurxs;
-
-				cpurxs = per_cpu_ptr(sta->deflink.pcpu_rx_stats,
-						     cpu);
-				sinfo->rx_bytes += sta_get_stats_bytes(cpurxs);
-			}
-		}
-
+		sinfo->rx_bytes += snap->bytes;
 		sinfo->filled |= BIT_ULL(NL80211_STA_INFO_RX_BYTES64);
 	}
 
 	if (!(sinfo->filled & BIT_ULL(NL80211_STA_INFO_RX_PACKETS))) {
-		sinfo->rx_packets = sta->deflink.rx_stats.packets;
-		if (sta->deflink.pcpu_rx_stats) {
-			for_each_possible_cpu(cpu) {
-				struct ieee80211_sta_rx_stats *cpurxs;
-
-				cpurxs = per_cpu_ptr(sta->deflink.pcpu_rx_stats,
-						     cpu);
-				sinfo->rx_packets += cpurxs->packets;
-			}
-		}
+		sinfo->rx_packets = snap->packets;
 		sinfo->filled |= BIT_ULL(NL80211_STA_INFO_RX_PACKETS);
 	}
 
@@ -2669,15 +2669,7 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 		sinfo->filled |= BIT_ULL(NL80211_STA_INFO_AIRTIME_WEIGHT);
 	}
 
-	sinfo->rx_dropped_misc = sta->deflink.rx_stats.dropped;
-	if (sta->deflink.pcpu_rx_stats) {
-		for_each_possible_cpu(cpu) {
-			struct ieee80211_sta_rx_stats *cpurxs;
-
-			cpurxs = per_cpu_ptr(sta->deflink.pcpu_rx_stats, cpu);
-			sinfo->rx_dropped_misc += cpurxs->dropped;
-		}
-	}
+	sinfo->rx_dropped_misc = snap->dropped;
 
 	if (sdata->vif.type == NL80211_IFTYPE_STATION &&
 	    !(sdata->vif.driver_flags & IEEE80211_VIF_BEACON_FILTER)) {
@@ -2693,7 +2685,7 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 			sinfo->filled |= BIT_ULL(NL80211_STA_INFO_SIGNAL);
 		}
 
-		if (!sta->deflink.pcpu_rx_stats &&
+		if (!ieee80211_hw_check(&local->hw, USES_RSS) &&
 		    !(sinfo->filled & BIT_ULL(NL80211_STA_INFO_SIGNAL_AVG))) {
 			sinfo->signal_avg =
 				-ewma_signal_read(&sta->deflink.rx_stats_avg.signal);
@@ -2701,15 +2693,14 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 		}
 	}
 
-	/* for the average - if pcpu_rx_stats isn't set - rxstats must point to
-	 * the sta->rx_stats struct, so the check here is fine with and without
-	 * pcpu statistics
+	/* the averages are only maintained if RX isn't spread over multiple
+	 * CPUs, but the last values are valid either way
 	 */
 	if (last_rxstats->chains &&
 	    !(sinfo->filled & (BIT_ULL(NL80211_STA_INFO_CHAIN_SIGNAL) |
 			       BIT_ULL(NL80211_STA_INFO_CHAIN_SIGNAL_AVG)))) {
 		sinfo->filled |= BIT_ULL(NL80211_STA_INFO_CHAIN_SIGNAL);
-		if (!sta->deflink.pcpu_rx_stats)
+		if (!ieee80211_hw_check(&local->hw, USES_RSS))
 			sinfo->filled |= BIT_ULL(NL80211_STA_INFO_CHAIN_SIGNAL_AVG);
 
 		sinfo->chains = last_rxstats->chains;
@@ -2738,7 +2729,7 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 
 	if (tidstats && !cfg80211_sinfo_alloc_tid_stats(sinfo, GFP_KERNEL)) {
 		for (i = 0; i < IEEE80211_NUM_TIDS + 1; i++)
-			sta_set_tidstats(sta, &sinfo->pertid[i], i);
+			sta_set_tidstats(sta, snap, &sinfo->pertid[i], i);
 	}
 
 	if (ieee80211_vif_is_mesh(&sdata->vif)) {
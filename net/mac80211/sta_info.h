@@ -140,6 +140,7 @@ struct airtime_info {
 	u64 tx_airtime;
 	u32 last_active;
 	s32 deficit;
+	u64 v_t; /* Weighted airtime used, for the virtual time scheduler */
 	atomic_t aql_tx_pending; /* Estimated airtime for frames pending */
 	u32 aql_limit_low;
 	u32 aql_limit_high;
@@ -147,7 +148,7 @@ struct airtime_info {
 
 void ieee80211_sta_update_pending_airtime(struct ieee80211_local *local,
 					  struct sta_info *sta, u8 ac,
-					  u16 tx_airtime, bool tx_completed);
+					  u32 tx_airtime, bool tx_completed);
 
 struct sta_info;
 
@@ -437,6 +438,24 @@ struct ieee80211_sta_rx_stats {
 	u64 msdu[IEEE80211_NUM_TIDS + 1];
 };
 
+/*
+ * RX counters summed up over the shared and all per-CPU statistics, cached
+ * for a short while so that polling station dumps don't walk all the CPUs
+ * for every station each time.
+ */
+#define STA_RX_STATS_SNAPSHOT_INTERVAL	(HZ / 10)
+
+struct ieee80211_sta_rx_stats_snapshot {
+	bool valid;
+	unsigned long updated;
+	u64 packets;
+	u64 bytes;
+	u64 num_duplicates;
+	u64 fragments;
+	u64 dropped;
+	u64 msdu[IEEE80211_NUM_TIDS + 1];
+};
+
 /*
  * IEEE 802.11-2016 (10.6 "Defragmentation") recommends support for "concurrent
  * reception of at least one MSDU per access category per associated STA"
@@ -493,8 +512,10 @@ struct ieee80211_fragment_cache {
  * @rx_stats_avg: averaged RX statistics
  * @rx_stats_avg.signal: averaged signal
  * @rx_stats_avg.chain_signal: averaged per-chain signal
- * @pcpu_rx_stats: per-CPU RX statistics, assigned only if the driver needs
- *	this (by advertising the USES_RSS hw flag)
+ * @pcpu_rx_stats: per-CPU RX statistics, updated by the fast-RX path so
+ *	that it doesn't write to shared counters (it may run on multiple CPUs
+ *	if the driver advertises the USES_RSS hw flag)
+ * @rx_stats_snapshot: summed up RX counters, see sta_get_rx_stats_snapshot()
  * @status_stats: TX status statistics
  * @status_stats.filtered: # of filtered frames
  * @status_stats.retry_failed: # of frames that failed after retry
@@ -532,6 +553,9 @@ struct link_sta_info {
 		struct ewma_signal chain_signal[IEEE80211_MAX_CHAINS];
 	} rx_stats_avg;
 
+	/* protected by the wiphy mutex */
+	struct ieee80211_sta_rx_stats_snapshot rx_stats_snapshot;
+
 	/* Updated from TX status path only, no locking requirements */
 	struct {
 		unsigned long filtered;
@@ -922,6 +946,9 @@ void ieee80211_sta_ps_deliver_uapsd(struct sta_info *sta);
 
 unsigned long ieee80211_sta_last_active(struct sta_info *sta);
 
+const struct ieee80211_sta_rx_stats_snapshot *
+sta_get_rx_stats_snapshot(struct sta_info *sta);
+
 void ieee80211_sta_set_max_amsdu_subframes(struct sta_info *sta,
 					   const u8 *ext_capab,
 					   unsigned int ext_capab_len);
@@ -1117,8 +1117,9 @@ void ieee80211_tx_status_skb(struct ieee80211_hw *hw, struct sk_buff *skb)
 }
 EXPORT_SYMBOL(ieee80211_tx_status_skb);
 
-void ieee80211_tx_status_ext(struct ieee80211_hw *hw,
-			     struct ieee80211_tx_status *status)
+static void ieee80211_tx_status_one(struct ieee80211_hw *hw,
+				    struct ieee80211_tx_status *status,
+				    bool report_rate)
 {
 	struct ieee80211_local *local = hw_to_local(hw);
 	struct ieee80211_tx_info *info = status->info;
@@ -1208,7 +1209,8 @@ void ieee80211_tx_status_ext(struct ieee80211_hw *hw,
 			}
 		}
 
-		rate_control_tx_status(local, status);
+		if (report_rate)
+			rate_control_tx_status(local, status);
 		if (ieee80211_vif_is_mesh(&sta->sdata->vif))
 			ieee80211s_update_metric(local, sta, status);
 	}
@@ -1243,8 +1245,64 @@ free:
 	else
 		dev_kfree_skb(skb);
 }
+
+void ieee80211_tx_status_ext(struct ieee80211_hw *hw,
+			     struct ieee80211_tx_status *status)
+{
+	ieee80211_tx_status_one(hw, status, true);
+}
 EXPORT_SYMBOL(ieee80211_tx_status_ext);
 
+void ieee80211_tx_status_list(struct ieee80211_hw *hw,
+			      struct ieee80211_sta *pubsta,
+			      struct sk_buff_head *skbs)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct sta_info *sta = container_of(pubsta, struct sta_info, sta);
+	struct ieee80211_tx_status status = {
+		.sta = pubsta,
+	};
+	struct sk_buff *skb;
+	u32 airtime = 0;
+	u8 ac = 0;
+
+	skb_queue_walk(skbs, skb) {
+		struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
+		u16 tx_time_est = ieee80211_info_get_tx_time_est(info);
+
+		if (!tx_time_est)
+			continue;
+
+		if (airtime && ac != skb_get_queue_mapping(skb)) {
+			ieee80211_sta_update_pending_airtime(local, sta, ac,
+							     airtime, true);
+			airtime = 0;
+		}
+
+		ac = skb_get_queue_mapping(skb);
+		airtime += tx_time_est;
+		ieee80211_info_set_tx_time_est(info, 0);
+	}
+
+	if (airtime)
+		ieee80211_sta_update_pending_airtime(local, sta, ac, airtime,
+						     true);
+
+	while ((skb = __skb_dequeue(skbs))) {
+		struct ieee80211_tx_info *info = IEEE80211_SKB_CB(skb);
+		bool report_rate;
+
+		/* rate control ignores the A-MPDU frames without its status */
+		report_rate = !(info->flags & IEEE80211_TX_CTL_AMPDU) ||
+			      (info->flags & IEEE80211_TX_STAT_AMPDU);
+
+		status.skb = skb;
+		status.info = info;
+		ieee80211_tx_status_one(hw, &status, report_rate);
+	}
+}
+EXPORT_SYMBOL(ieee80211_tx_status_list);
+
 void ieee80211_tx_rate_update(struct ieee80211_hw *hw,
 			      struct ieee80211_sta *pubsta,
 			      struct ieee80211_tx_info *info)
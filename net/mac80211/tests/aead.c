@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for software CCMP/GCMP
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include <linux/random.h>
+#include <crypto/aes.h>
+#include "../ieee80211_i.h"
+#include "../aead_api.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+#define AEAD_TEST_FRAME_LEN	1500
+#define AEAD_TEST_AAD_LEN	30
+
+static const struct aead_test_case {
+	const char *desc;
+	const char *alg;
+	size_t key_len, mic_len;
+} aead_test_cases[] = {
+	{
+		.desc = "CCMP",
+		.alg = "ccm(aes)",
+		.key_len = WLAN_KEY_LEN_CCMP,
+		.mic_len = IEEE80211_CCMP_MIC_LEN,
+	},
+	{
+		.desc = "CCMP-256",
+		.alg = "ccm(aes)",
+		.key_len = WLAN_KEY_LEN_CCMP_256,
+		.mic_len = IEEE80211_CCMP_256_MIC_LEN,
+	},
+	{
+		.desc = "GCMP",
+		.alg = "gcm(aes)",
+		.key_len = WLAN_KEY_LEN_GCMP,
+		.mic_len = IEEE80211_GCMP_MIC_LEN,
+	},
+	{
+		.desc = "GCMP-256",
+		.alg = "gcm(aes)",
+		.key_len = WLAN_KEY_LEN_GCMP_256,
+		.mic_len = IEEE80211_GCMP_MIC_LEN,
+	},
+};
+
+KUNIT_ARRAY_PARAM_DESC(aead_test, aead_test_cases, desc);
+
+struct aead_test {
+	struct aead_key *aead;
+	u8 iv[AES_BLOCK_SIZE];
+	u8 aad[AEAD_TEST_AAD_LEN];
+	u8 mic[IEEE80211_GCMP_MIC_LEN];
+	u8 *data, *orig;
+};
+
+static void aead_test_free(void *data)
+{
+	aead_key_free(data);
+}
+
+static struct aead_test *aead_test_alloc(struct kunit *test)
+{
+	const struct aead_test_case *params = test->param_value;
+	u8 key[WLAN_KEY_LEN_GCMP_256];
+	struct aead_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+	t->data = kunit_kmalloc(test, AEAD_TEST_FRAME_LEN, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->data);
+	t->orig = kunit_kmalloc(test, AEAD_TEST_FRAME_LEN, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->orig);
+
+	get_random_bytes(key, params->key_len);
+	t->aead = aead_key_setup_encrypt(params->alg, key, params->key_len,
+					 params->mic_len);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->aead));
+	KUNIT_ASSERT_EQ(test, 0,
+			kunit_add_action_or_reset(test, aead_test_free,
+						  t->aead));
+
+	/* like ccmp_special_blocks(): L' = 1, i.e. a two byte length */
+	get_random_bytes(t->iv, sizeof(t->iv));
+	t->iv[0] = 1;
+	get_random_bytes(t->aad, sizeof(t->aad));
+	for (i = 0; i < AEAD_TEST_FRAME_LEN; i++)
+		t->orig[i] = i;
+
+	return t;
+}
+
+static void aead_roundtrip(struct kunit *test)
+{
+	struct aead_test *t = aead_test_alloc(test);
+	u8 iv[AES_BLOCK_SIZE];
+
+	memcpy(t->data, t->orig, AEAD_TEST_FRAME_LEN);
+	/* the IV buffer is modified by ccm(aes) */
+	memcpy(iv, t->iv, sizeof(iv));
+	KUNIT_ASSERT_EQ(test, 0,
+			aead_encrypt(t->aead, iv, t->aad, sizeof(t->aad),
+				     t->data, AEAD_TEST_FRAME_LEN, t->mic));
+	KUNIT_EXPECT_NE(test, 0,
+			memcmp(t->data, t->orig, AEAD_TEST_FRAME_LEN));
+
+	memcpy(iv, t->iv, sizeof(iv));
+	KUNIT_ASSERT_EQ(test, 0,
+			aead_decrypt(t->aead, iv, t->aad, sizeof(t->aad),
+				     t->data, AEAD_TEST_FRAME_LEN, t->mic));
+	KUNIT_EXPECT_EQ(test, 0,
+			memcmp(t->data, t->orig, AEAD_TEST_FRAME_LEN));
+
+	/* a reused request must not carry over anything from the last one */
+	memcpy(iv, t->iv, sizeof(iv));
+	t->aad[0] ^= 1;
+	KUNIT_EXPECT_EQ(test, -EBADMSG,
+			aead_decrypt(t->aead, iv, t->aad, sizeof(t->aad),
+				     t->data, AEAD_TEST_FRAME_LEN, t->mic));
+}
+
+static struct kunit_case aead_sw_crypto_test_cases[] = {
+	KUNIT_CASE_PARAM(aead_roundtrip, aead_test_gen_params),
+	{}
+};
+
+static struct kunit_suite aead_sw_crypto = {
+	.name = "mac80211-aead",
+	.test_cases = aead_sw_crypto_test_cases,
+};
+
+kunit_test_suite(aead_sw_crypto);
@@ -89,8 +89,120 @@ free_skb:
 	kfree_skb(skb);
 }
 
+/* roughly what a 6 GHz AP advertises in its beacons */
+static const struct {
+	u8 id, len;
+} beacon_elems[] = {
+	{ WLAN_EID_SSID, 8 },
+	{ WLAN_EID_SUPP_RATES, 8 },
+	{ WLAN_EID_DS_PARAMS, 1 },
+	{ WLAN_EID_TIM, 6 },
+	{ WLAN_EID_COUNTRY, 6 },
+	{ WLAN_EID_PWR_CONSTRAINT, 1 },
+	{ WLAN_EID_RSN, 20 },
+	{ WLAN_EID_HT_CAPABILITY, sizeof(struct ieee80211_ht_cap) },
+	{ WLAN_EID_HT_OPERATION, sizeof(struct ieee80211_ht_operation) },
+	{ WLAN_EID_EXT_CAPABILITY, 10 },
+	{ WLAN_EID_VHT_CAPABILITY, sizeof(struct ieee80211_vht_cap) },
+	{ WLAN_EID_VHT_OPERATION, sizeof(struct ieee80211_vht_operation) },
+	{ WLAN_EID_TX_POWER_ENVELOPE, 3 },
+	{ WLAN_EID_TX_POWER_ENVELOPE, 3 },
+	{ WLAN_EID_REDUCED_NEIGHBOR_REPORT, 120 },
+	{ WLAN_EID_RSNX, 1 },
+};
+
+/* HE capabilities (all zero, so no optional fields) and operation */
+#define BEACON_HE_CAP_LEN	(sizeof(struct ieee80211_he_cap_elem) + 4)
+#define BEACON_HE_OPER_LEN	sizeof(struct ieee80211_he_operation)
+
+/* like care_about_ies in mlme.c */
+#define BEACON_CRC_FILTER	((1ULL << WLAN_EID_COUNTRY) |		\
+				 (1ULL << WLAN_EID_ERP_INFO) |		\
+				 (1ULL << WLAN_EID_CHANNEL_SWITCH) |	\
+				 (1ULL << WLAN_EID_PWR_CONSTRAINT) |	\
+				 (1ULL << WLAN_EID_HT_CAPABILITY) |	\
+				 (1ULL << WLAN_EID_HT_OPERATION) |	\
+				 (1ULL << WLAN_EID_EXT_CHANSWITCH_ANN))
+
+static struct sk_buff *beacon_elems_build(struct kunit *test)
+{
+	static const u8 wmm_param[] = { 0x00, 0x50, 0xf2, 0x02, 0x01, 0x01 };
+	struct sk_buff *skb;
+	int i;
+
+	skb = alloc_skb(1024, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, skb);
+
+	for (i = 0; i < ARRAY_SIZE(beacon_elems); i++) {
+		skb_put_u8(skb, beacon_elems[i].id);
+		skb_put_u8(skb, beacon_elems[i].len);
+		skb_put_zero(skb, beacon_elems[i].len);
+	}
+
+	skb_put_u8(skb, WLAN_EID_EXTENSION);
+	skb_put_u8(skb, 1 + BEACON_HE_CAP_LEN);
+	skb_put_u8(skb, WLAN_EID_EXT_HE_CAPABILITY);
+	skb_put_zero(skb, BEACON_HE_CAP_LEN);
+
+	skb_put_u8(skb, WLAN_EID_EXTENSION);
+	skb_put_u8(skb, 1 + BEACON_HE_OPER_LEN);
+	skb_put_u8(skb, WLAN_EID_EXT_HE_OPERATION);
+	skb_put_zero(skb, BEACON_HE_OPER_LEN);
+
+	skb_put_u8(skb, WLAN_EID_VENDOR_SPECIFIC);
+	skb_put_u8(skb, 24);
+	skb_put_data(skb, wmm_param, sizeof(wmm_param));
+	skb_put_zero(skb, 24 - sizeof(wmm_param));
+
+	return skb;
+}
+
+static void parse_classes(struct kunit *test)
+{
+	struct sk_buff *skb = beacon_elems_build(test);
+	struct ieee80211_elems_parse_params parse_params = {
+		.mode = IEEE80211_CONN_MODE_EHT,
+		.start = skb->data,
+		.len = skb->len,
+		.filter = BEACON_CRC_FILTER,
+		.link_id = -1,
+		.from_ap = true,
+	};
+	struct ieee802_11_elems *all, *tim;
+
+	all = ieee802_11_parse_elems_full(&parse_params);
+	KUNIT_ASSERT_NOT_NULL(test, all);
+	parse_params.classes = BIT(IEEE80211_ELEMS_TIM);
+	tim = ieee802_11_parse_elems_full(&parse_params);
+	KUNIT_ASSERT_NOT_NULL(test, tim);
+
+	KUNIT_EXPECT_FALSE(test, all->parse_error);
+	KUNIT_EXPECT_NOT_NULL(test, all->ht_cap_elem);
+	KUNIT_EXPECT_NOT_NULL(test, all->he_operation);
+	KUNIT_EXPECT_NOT_NULL(test, all->wmm_param);
+
+	/* the TIM is there, the CRC is the same, but nothing else is parsed */
+	KUNIT_EXPECT_PTR_EQ(test, tim->tim, all->tim);
+	KUNIT_EXPECT_EQ(test, tim->crc, all->crc);
+	KUNIT_EXPECT_NULL(test, tim->ssid);
+	KUNIT_EXPECT_NULL(test, tim->rsn);
+	KUNIT_EXPECT_NULL(test, tim->ht_cap_elem);
+
+	/* a changed element outside the classes must still change the CRC */
+	skb->data[skb->len - 1] ^= 1;
+	kfree(tim);
+	tim = ieee802_11_parse_elems_full(&parse_params);
+	KUNIT_ASSERT_NOT_NULL(test, tim);
+	KUNIT_EXPECT_NE(test, tim->crc, all->crc);
+
+	kfree(tim);
+	kfree(all);
+	kfree_skb(skb);
+}
+
 static struct kunit_case element_parsing_test_cases[] = {
 	KUNIT_CASE(mle_defrag),
+	KUNIT_CASE(parse_classes),
 	{}
 };
 
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the airtime fairness TXQ schedulers
+ *
+ * Copyright (C) 2023 Intel Corporation
+ */
+#include <kunit/test.h>
+#include "../ieee80211_i.h"
+#include "../sta_info.h"
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+
+#define SCHED_TEST_AIRTIME	2000 /* us per scheduled TXQ */
+
+struct sched_test {
+	struct ieee80211_local *local;
+	struct ieee80211_sub_if_data *sdata;
+	struct sta_info **sta;
+	struct txq_info **txqi;
+	int n_sta;
+};
+
+static const struct sched_test_case {
+	const char *desc;
+	enum ieee80211_airtime_sched sched;
+} sched_test_cases[] = {
+	{
+		.desc = "DRR",
+		.sched = IEEE80211_AIRTIME_SCHED_DRR,
+	},
+	{
+		.desc = "virtual time",
+		.sched = IEEE80211_AIRTIME_SCHED_VT,
+	},
+};
+
+KUNIT_ARRAY_PARAM_DESC(sched_test, sched_test_cases, desc);
+
+/*
+ * Set up just enough of a device and its stations for the scheduler: one
+ * backlogged BE TXQ per station, all of them active.
+ */
+static struct sched_test *sched_test_alloc(struct kunit *test, int n_sta,
+					   enum ieee80211_airtime_sched sched)
+{
+	struct ieee80211_local *local;
+	struct sched_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+	t->local = local = kunit_kzalloc(test, sizeof(*local), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, local);
+	local->hw.wiphy = kunit_kzalloc(test, sizeof(*local->hw.wiphy),
+					GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, local->hw.wiphy);
+	t->sdata = kunit_kzalloc(test, sizeof(*t->sdata), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->sdata);
+	t->sdata->local = local;
+
+	for (i = 0; i < IEEE80211_NUM_ACS; i++) {
+		INIT_LIST_HEAD(&local->active_txqs[i]);
+		local->active_txq_tree[i] = RB_ROOT_CACHED;
+		spin_lock_init(&local->active_txq_lock[i]);
+		local->aql_txq_limit_low[i] = IEEE80211_DEFAULT_AQL_TXQ_LIMIT_L;
+		local->aql_txq_limit_high[i] =
+			IEEE80211_DEFAULT_AQL_TXQ_LIMIT_H;
+	}
+	local->airtime_flags = AIRTIME_USE_TX;
+	local->aql_threshold = IEEE80211_AQL_THRESHOLD;
+	ieee80211_set_airtime_sched(local, sched);
+
+	t->n_sta = n_sta;
+	t->sta = kunit_kcalloc(test, n_sta, sizeof(*t->sta), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->sta);
+	t->txqi = kunit_kcalloc(test, n_sta, sizeof(*t->txqi), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->txqi);
+
+	for (i = 0; i < n_sta; i++) {
+		struct sta_info *sta;
+		struct txq_info *txqi;
+		int ac;
+
+		t->sta[i] = sta = kunit_kzalloc(test, sizeof(*sta), GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, sta);
+		t->txqi[i] = txqi = kunit_kzalloc(test, sizeof(*txqi),
+						  GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, txqi);
+
+		sta->local = local;
+		sta->sdata = t->sdata;
+		sta->airtime_weight = IEEE80211_DEFAULT_AIRTIME_WEIGHT;
+		for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+			sta->airtime[ac].deficit = sta->airtime_weight;
+			sta->airtime[ac].aql_limit_low =
+				local->aql_txq_limit_low[ac];
+			sta->airtime[ac].aql_limit_high =
+				local->aql_txq_limit_high[ac];
+		}
+
+		__skb_queue_head_init(&txqi->frags);
+		INIT_LIST_HEAD(&txqi->schedule_order);
+		RB_CLEAR_NODE(&txqi->schedule_node);
+		/* pretend there's always something to send */
+		txqi->tin.backlog_packets = 1;
+		txqi->txq.sta = &sta->sta;
+		txqi->txq.tid = 0;
+		txqi->txq.ac = IEEE80211_AC_BE;
+		sta->sta.txq[0] = &txqi->txq;
+	}
+
+	return t;
+}
+
+/* run one scheduling round the way drivers do, charging the airtime */
+static struct ieee80211_txq *sched_test_round(struct sched_test *t)
+{
+	struct ieee80211_hw *hw = &t->local->hw;
+	struct ieee80211_txq *txq;
+
+	ieee80211_txq_schedule_start(hw, IEEE80211_AC_BE);
+	txq = ieee80211_next_txq(hw, IEEE80211_AC_BE);
+	if (!txq)
+		return NULL;
+
+	ieee80211_sta_register_airtime(txq->sta, txq->tid,
+				       SCHED_TEST_AIRTIME, 0);
+	ieee80211_return_txq(hw, txq, false);
+
+	return txq;
+}
+
+static void sched_test_schedule_all(struct sched_test *t)
+{
+	int i;
+
+	for (i = 0; i < t->n_sta; i++)
+		ieee80211_schedule_txq(&t->local->hw, &t->txqi[i]->txq);
+}
+
+#define SCHED_FAIRNESS_ROUNDS	3000
+
+static void sched_fairness(struct kunit *test)
+{
+	const struct sched_test_case *params = test->param_value;
+	struct sched_test *t = sched_test_alloc(test, 3, params->sched);
+	u64 airtime[3];
+	int i;
+
+	/* station 2 is entitled to twice the airtime of the others */
+	t->sta[2]->airtime_weight = 2 * IEEE80211_DEFAULT_AIRTIME_WEIGHT;
+	sched_test_schedule_all(t);
+
+	for (i = 0; i < SCHED_FAIRNESS_ROUNDS; i++)
+		KUNIT_ASSERT_NOT_NULL(test, sched_test_round(t));
+
+	for (i = 0; i < ARRAY_SIZE(airtime); i++)
+		airtime[i] = t->sta[i]->airtime[IEEE80211_AC_BE].tx_airtime;
+
+	KUNIT_EXPECT_EQ(test, airtime[0] + airtime[1] + airtime[2],
+			(u64)SCHED_FAIRNESS_ROUNDS * SCHED_TEST_AIRTIME);
+	/* allow for a few rounds of rounding either way */
+	KUNIT_EXPECT_LE(test, abs((s64)airtime[0] - (s64)airtime[1]),
+			4 * SCHED_TEST_AIRTIME);
+	KUNIT_EXPECT_LE(test, abs((s64)airtime[2] - 2 * (s64)airtime[0]),
+			8 * SCHED_TEST_AIRTIME);
+}
+
+static void sched_aql(struct kunit *test)
+{
+	const struct sched_test_case *params = test->param_value;
+	struct sched_test *t = sched_test_alloc(test, 2, params->sched);
+	struct airtime_info *air_info = &t->sta[0]->airtime[IEEE80211_AC_BE];
+	int i;
+
+	wiphy_ext_feature_set(t->local->hw.wiphy, NL80211_EXT_FEATURE_AQL);
+	sched_test_schedule_all(t);
+
+	/* station 0 has more airtime in flight than AQL allows */
+	atomic_set(&air_info->aql_tx_pending, air_info->aql_limit_high);
+	for (i = 0; i < 10; i++)
+		KUNIT_EXPECT_PTR_EQ(test, sched_test_round(t),
+				    &t->txqi[1]->txq);
+
+	/* but it must be scheduled again once that's completed */
+	atomic_set(&air_info->aql_tx_pending, 0);
+	for (i = 0; i < 10; i++)
+		if (sched_test_round(t) == &t->txqi[0]->txq)
+			break;
+	KUNIT_EXPECT_LT(test, i, 10);
+}
+
+static void sched_switch(struct kunit *test)
+{
+	struct sched_test *t = sched_test_alloc(test, 4,
+						IEEE80211_AIRTIME_SCHED_DRR);
+	int i;
+
+	sched_test_schedule_all(t);
+
+	/* active TXQs must move over and still be scheduled */
+	for (i = 0; i < 4; i++) {
+		enum ieee80211_airtime_sched sched = IEEE80211_AIRTIME_SCHED_VT;
+
+		if (i % 2)
+			sched = IEEE80211_AIRTIME_SCHED_DRR;
+		ieee80211_set_airtime_sched(t->local, sched);
+		KUNIT_EXPECT_NOT_NULL(test, sched_test_round(t));
+	}
+
+	ieee80211_set_airtime_sched(t->local, IEEE80211_AIRTIME_SCHED_VT);
+	KUNIT_EXPECT_EQ(test,
+			t->local->active_txq_tree_len[IEEE80211_AC_BE], 4);
+	KUNIT_EXPECT_TRUE(test,
+			  list_empty(&t->local->active_txqs[IEEE80211_AC_BE]));
+}
+
+static struct kunit_case airtime_sched_test_cases[] = {
+	KUNIT_CASE_PARAM(sched_fairness, sched_test_gen_params),
+	KUNIT_CASE_PARAM(sched_aql, sched_test_gen_params),
+	KUNIT_CASE(sched_switch),
+	{}
+};
+
+static struct kunit_suite airtime_sched = {
+	.name = "mac80211-airtime-sched",
+	.test_cases = airtime_sched_test_cases,
+};
+
+kunit_test_suite(airtime_sched);
@@ -1507,6 +1507,7 @@ void ieee80211_txq_init(struct ieee80211_sub_if_data *sdata,
 	codel_stats_init(&txqi->cstats);
 	__skb_queue_head_init(&txqi->frags);
 	INIT_LIST_HEAD(&txqi->schedule_order);
+	RB_CLEAR_NODE(&txqi->schedule_node);
 
 	txqi->txq.vif = &sdata->vif;
 
@@ -1551,7 +1552,7 @@ void ieee80211_txq_purge(struct ieee80211_local *local,
 	spin_unlock_bh(&fq->lock);
 
 	spin_lock_bh(&local->active_txq_lock[txqi->txq.ac]);
-	list_del_init(&txqi->schedule_order);
+	ieee80211_txq_unschedule(local, txqi);
 	spin_unlock_bh(&local->active_txq_lock[txqi->txq.ac]);
 }
 
@@ -4026,6 +4027,201 @@ static inline s32 ieee80211_sta_deficit(struct sta_info *sta, u8 ac)
 	return air_info->deficit - atomic_read(&air_info->aql_tx_pending);
 }
 
+static u64 ieee80211_sta_vt(struct sta_info *sta, u8 ac)
+{
+	struct airtime_info *air_info = &sta->airtime[ac];
+	int pending = atomic_read(&air_info->aql_tx_pending);
+
+	/* like the deficit, count the airtime we've already committed to */
+	return air_info->v_t +
+	       div_u64((u64)max(pending, 0) << AIRTIME_VT_SHIFT,
+		       sta->airtime_weight);
+}
+
+static bool ieee80211_txq_sched_vt(struct ieee80211_local *local, u8 ac)
+{
+	return local->airtime_sched[ac] == IEEE80211_AIRTIME_SCHED_VT;
+}
+
+static void ieee80211_txq_vt_insert(struct ieee80211_local *local,
+				    struct txq_info *txqi)
+{
+	struct rb_root_cached *root = &local->active_txq_tree[txqi->txq.ac];
+	struct rb_node **new = &root->rb_root.rb_node, *parent = NULL;
+	bool leftmost = true;
+
+	while (*new) {
+		struct txq_info *iter = rb_entry(*new, struct txq_info,
+						 schedule_node);
+
+		parent = *new;
+		if (txqi->schedule_vt < iter->schedule_vt) {
+			new = &parent->rb_left;
+		} else {
+			new = &parent->rb_right;
+			leftmost = false;
+		}
+	}
+
+	rb_link_node(&txqi->schedule_node, parent, new);
+	rb_insert_color_cached(&txqi->schedule_node, root, leftmost);
+	local->active_txq_tree_len[txqi->txq.ac]++;
+}
+
+static void ieee80211_txq_vt_erase(struct ieee80211_local *local,
+				   struct txq_info *txqi)
+{
+	rb_erase_cached(&txqi->schedule_node,
+			&local->active_txq_tree[txqi->txq.ac]);
+	RB_CLEAR_NODE(&txqi->schedule_node);
+	local->active_txq_tree_len[txqi->txq.ac]--;
+}
+
+/*
+ * Queue a TXQ by the virtual time of its station. A station coming back
+ * from idle starts at the current virtual time, so it can't claim the
+ * airtime it didn't use while it had nothing to send.
+ */
+static void ieee80211_txq_vt_schedule(struct ieee80211_local *local,
+				      struct txq_info *txqi)
+{
+	u8 ac = txqi->txq.ac;
+	u64 v_t = local->airtime_v_t[ac];
+
+	if (txqi->txq.sta) {
+		struct sta_info *sta = container_of(txqi->txq.sta,
+						    struct sta_info, sta);
+		u64 sta_v_t = ieee80211_sta_vt(sta, ac);
+
+		if (sta_v_t < v_t)
+			sta->airtime[ac].v_t += v_t - sta_v_t;
+		else
+			v_t = sta_v_t;
+	}
+
+	txqi->schedule_vt = v_t;
+	ieee80211_txq_vt_insert(local, txqi);
+}
+
+void ieee80211_txq_unschedule(struct ieee80211_local *local,
+			      struct txq_info *txqi)
+{
+	lockdep_assert_held(&local->active_txq_lock[txqi->txq.ac]);
+
+	if (!RB_EMPTY_NODE(&txqi->schedule_node))
+		ieee80211_txq_vt_erase(local, txqi);
+	if (!list_empty(&txqi->schedule_order))
+		list_del_init(&txqi->schedule_order);
+}
+
+static bool ieee80211_txq_scheduled(struct txq_info *txqi)
+{
+	return !RB_EMPTY_NODE(&txqi->schedule_node) ||
+	       !list_empty(&txqi->schedule_order);
+}
+
+static void ieee80211_txq_vt_update(struct ieee80211_local *local,
+				    struct txq_info *txqi)
+{
+	u8 ac = txqi->txq.ac;
+
+	if (txqi->schedule_vt > local->airtime_v_t[ac])
+		local->airtime_v_t[ac] = txqi->schedule_vt;
+}
+
+static struct txq_info *
+ieee80211_next_txq_vt(struct ieee80211_hw *hw, u8 ac)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+	struct rb_root_cached *root = &local->active_txq_tree[ac];
+	u32 refresh = local->active_txq_tree_len[ac];
+	struct rb_node *node = rb_first_cached(root);
+
+	while (node) {
+		struct txq_info *txqi = rb_entry(node, struct txq_info,
+						 schedule_node);
+
+		if (txqi->txq.sta) {
+			struct sta_info *sta = container_of(txqi->txq.sta,
+							    struct sta_info,
+							    sta);
+			u64 v_t = ieee80211_sta_vt(sta, ac);
+
+			/*
+			 * The key was sampled when the TXQ was queued, airtime
+			 * reported since then may have moved it further back.
+			 * Re-sort it, it'll come up again later in this walk.
+			 */
+			if (v_t > txqi->schedule_vt && refresh) {
+				struct rb_node *prev = rb_prev(node);
+
+				refresh--;
+				ieee80211_txq_vt_erase(local, txqi);
+				txqi->schedule_vt = v_t;
+				ieee80211_txq_vt_insert(local, txqi);
+				node = prev ? rb_next(prev) :
+					      rb_first_cached(root);
+				continue;
+			}
+
+			if (!ieee80211_txq_airtime_check(hw, &txqi->txq)) {
+				node = rb_next(node);
+				continue;
+			}
+		}
+
+		if (txqi->schedule_round == local->schedule_round[ac])
+			return NULL;
+
+		ieee80211_txq_vt_erase(local, txqi);
+		ieee80211_txq_vt_update(local, txqi);
+		txqi->schedule_round = local->schedule_round[ac];
+		return txqi;
+	}
+
+	return NULL;
+}
+
+void ieee80211_set_airtime_sched(struct ieee80211_local *local,
+				 enum ieee80211_airtime_sched sched)
+{
+	struct txq_info *txqi, *tmp;
+	struct rb_node *node;
+	int ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		struct rb_root_cached *root = &local->active_txq_tree[ac];
+
+		spin_lock_bh(&local->active_txq_lock[ac]);
+
+		if (local->airtime_sched[ac] == sched)
+			goto next;
+
+		/* move all active TXQs over, keeping their order */
+		if (sched == IEEE80211_AIRTIME_SCHED_VT) {
+			list_for_each_entry_safe(txqi, tmp,
+						 &local->active_txqs[ac],
+						 schedule_order) {
+				list_del_init(&txqi->schedule_order);
+				ieee80211_txq_vt_schedule(local, txqi);
+			}
+		} else {
+			while ((node = rb_first_cached(root))) {
+				txqi = rb_entry(node, struct txq_info,
+						schedule_node);
+				ieee80211_txq_vt_erase(local, txqi);
+				list_add_tail(&txqi->schedule_order,
+					      &local->active_txqs[ac]);
+			}
+		}
+
+		local->airtime_sched[ac] = sched;
+next:
+		spin_unlock_bh(&local->active_txq_lock[ac]);
+	}
+}
+EXPORT_SYMBOL_IF_MAC80211_KUNIT(ieee80211_set_airtime_sched);
+
 static void
 ieee80211_txq_set_active(struct txq_info *txqi)
 {
@@ -4068,6 +4264,13 @@ struct ieee80211_txq *ieee80211_next_txq(struct ieee80211_hw *hw, u8 ac)
 	if (!local->schedule_round[ac])
 		goto out;
 
+	if (ieee80211_txq_sched_vt(local, ac)) {
+		txqi = ieee80211_next_txq_vt(hw, ac);
+		if (txqi)
+			ret = &txqi->txq;
+		goto out;
+	}
+
  begin:
 	txqi = list_first_entry_or_null(&local->active_txqs[ac],
 					struct txq_info,
@@ -4129,8 +4332,17 @@ void __ieee80211_schedule_txq(struct ieee80211_hw *hw,
 	spin_lock_bh(&local->active_txq_lock[txq->ac]);
 
 	has_queue = force || txq_has_queue(txq);
-	if (list_empty(&txqi->schedule_order) &&
-	    (has_queue || ieee80211_txq_keep_active(txqi))) {
+	if (ieee80211_txq_sched_vt(local, txq->ac)) {
+		/*
+		 * The station's virtual time carries its airtime usage, so
+		 * unlike with DRR there's no need to keep idle TXQs around.
+		 */
+		if (RB_EMPTY_NODE(&txqi->schedule_node) && has_queue) {
+			ieee80211_txq_vt_schedule(local, txqi);
+			ieee80211_txq_set_active(txqi);
+		}
+	} else if (list_empty(&txqi->schedule_order) &&
+		   (has_queue || ieee80211_txq_keep_active(txqi))) {
 		/* If airtime accounting is active, always enqueue STAs at the
 		 * head of the list to ensure that they only get moved to the
 		 * back by the airtime DRR scheduler once they have a negative
@@ -4203,8 +4415,12 @@ ieee80211_txq_schedule_airtime_check(struct ieee80211_local *local, u8 ac)
 	if (!wiphy_ext_feature_isset(local->hw.wiphy, NL80211_EXT_FEATURE_AQL))
 		return true;
 
-	list_for_each_entry(txq, &local->active_txqs[ac], schedule_order)
-		num_txq++;
+	if (ieee80211_txq_sched_vt(local, ac))
+		num_txq = local->active_txq_tree_len[ac];
+	else
+		list_for_each_entry(txq, &local->active_txqs[ac],
+				    schedule_order)
+			num_txq++;
 
 	aql_limit = (num_txq - 1) * local->aql_txq_limit_low[ac] / 2 +
 		    local->aql_txq_limit_high[ac];
@@ -4225,12 +4441,32 @@ bool ieee80211_txq_may_transmit(struct ieee80211_hw *hw,
 	if (!txqi->txq.sta)
 		goto out;
 
-	if (list_empty(&txqi->schedule_order))
+	if (!ieee80211_txq_scheduled(txqi))
 		goto out;
 
 	if (!ieee80211_txq_schedule_airtime_check(local, ac))
 		goto out;
 
+	if (ieee80211_txq_sched_vt(local, ac)) {
+		struct rb_node *first;
+
+		/*
+		 * Only let the TXQ go ahead of the others while it hasn't
+		 * used more than its share, i.e. it's behind the virtual time
+		 * or it's the one furthest behind.
+		 */
+		first = rb_first_cached(&local->active_txq_tree[ac]);
+		sta = container_of(txqi->txq.sta, struct sta_info, sta);
+		if (first == &txqi->schedule_node ||
+		    ieee80211_sta_vt(sta, ac) <= local->airtime_v_t[ac]) {
+			ieee80211_txq_vt_update(local, txqi);
+			goto out;
+		}
+
+		spin_unlock_bh(&local->active_txq_lock[ac]);
+		return false;
+	}
+
 	list_for_each_entry_safe(iter, tmp, &local->active_txqs[ac],
 				 schedule_order) {
 		if (iter == txqi)
@@ -4257,8 +4493,7 @@ bool ieee80211_txq_may_transmit(struct ieee80211_hw *hw,
 
 	return false;
 out:
-	if (!list_empty(&txqi->schedule_order))
-		list_del_init(&txqi->schedule_order);
+	ieee80211_txq_unschedule(local, txqi);
 	spin_unlock_bh(&local->active_txq_lock[ac]);
 
 	return true;
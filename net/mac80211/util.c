@@ -1049,6 +1049,86 @@ ieee80211_parse_extension_element(u32 *crc,
 		*crc = crc32_be(*crc, (void *)elem, elem->datalen + 2);
 }
 
+/*
+ * Per element ID: the classes of elements its parser may fill in, whether
+ * it may only appear once, and whether the parser may add it to the CRC
+ * (in addition to the filter) so it can't be skipped when calculating it.
+ */
+struct ieee80211_elem_desc {
+	u16 classes;
+	u8 flags;
+};
+
+#define IEEE80211_ELEM_UNIQUE	BIT(0)
+#define IEEE80211_ELEM_CRC	BIT(1)
+
+#define ELEM_CLASS(_class)	BIT(IEEE80211_ELEMS_##_class)
+#define ELEM_DESC(_id, _classes, _flags) \
+	[WLAN_EID_##_id] = { .classes = _classes, .flags = _flags }
+
+static const struct ieee80211_elem_desc ieee80211_elem_descs[256] = {
+	ELEM_DESC(SSID, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(SUPP_RATES, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(FH_PARAMS, 0, IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(DS_PARAMS, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(CF_PARAMS, 0, IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(TIM, ELEM_CLASS(TIM), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(IBSS_PARAMS, 0, IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(CHALLENGE, 0, IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(RSN, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(ERP_INFO, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(EXT_SUPP_RATES, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(HT_CAPABILITY, ELEM_CLASS(HT), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(HT_OPERATION, ELEM_CLASS(HT), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(VHT_CAPABILITY, ELEM_CLASS(VHT), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(VHT_OPERATION, ELEM_CLASS(VHT),
+		  IEEE80211_ELEM_UNIQUE | IEEE80211_ELEM_CRC),
+	ELEM_DESC(OPMODE_NOTIF, ELEM_CLASS(VHT), IEEE80211_ELEM_CRC),
+	ELEM_DESC(MESH_ID, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(MESH_CONFIG, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(PEER_MGMT, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(MESH_AWAKE_WINDOW, ELEM_CLASS(MESH), 0),
+	ELEM_DESC(PREQ, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(PREP, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(PERR, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(RANN, ELEM_CLASS(MESH), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(CHANNEL_SWITCH, ELEM_CLASS(CSA), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(EXT_CHANSWITCH_ANN, ELEM_CLASS(CSA), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(COUNTRY, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(PWR_CONSTRAINT, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(TIMEOUT_INTERVAL, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(SECONDARY_CHANNEL_OFFSET, ELEM_CLASS(HT) | ELEM_CLASS(CSA),
+		  IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(WIDE_BW_CHANNEL_SWITCH, ELEM_CLASS(CSA),
+		  IEEE80211_ELEM_UNIQUE),
+	/*
+	 * not unique -- it seems possible that if the content gets bigger
+	 * it might be needed more than once
+	 */
+	ELEM_DESC(CHANNEL_SWITCH_WRAPPER, ELEM_CLASS(CSA), 0),
+	ELEM_DESC(CHAN_SWITCH_PARAM, ELEM_CLASS(MESH) | ELEM_CLASS(CSA),
+		  IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(EXT_CAPABILITY, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(CHAN_SWITCH_TIMING, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(LINK_ID, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(BSS_MAX_IDLE_PERIOD, ELEM_CLASS(BASIC),
+		  IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(RSNX, ELEM_CLASS(BASIC), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(ADDBA_EXT, ELEM_CLASS(BASIC), 0),
+	ELEM_DESC(TX_POWER_ENVELOPE, ELEM_CLASS(BASIC), 0),
+	ELEM_DESC(VENDOR_SPECIFIC, ELEM_CLASS(WMM), IEEE80211_ELEM_CRC),
+	ELEM_DESC(CISCO_VENDOR_SPECIFIC, ELEM_CLASS(BASIC), IEEE80211_ELEM_CRC),
+	ELEM_DESC(EXTENSION,
+		  ELEM_CLASS(BASIC) | ELEM_CLASS(HE) | ELEM_CLASS(EHT) |
+		  ELEM_CLASS(CSA),
+		  IEEE80211_ELEM_CRC),
+	ELEM_DESC(S1G_BCN_COMPAT, ELEM_CLASS(S1G), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(S1G_CAPABILITIES, ELEM_CLASS(S1G), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(S1G_OPERATION, ELEM_CLASS(S1G), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(AID_RESPONSE, ELEM_CLASS(S1G), IEEE80211_ELEM_UNIQUE),
+	ELEM_DESC(S1G_SHORT_BCN_INTERVAL, 0, IEEE80211_ELEM_UNIQUE),
+};
+
 static u32
 _ieee802_11_parse_elems_full(struct ieee80211_elems_parse_params *params,
 			     struct ieee802_11_elems *elems,
@@ -1062,6 +1142,8 @@ _ieee802_11_parse_elems_full(struct ieee80211_elems_parse_params *params,
 	bitmap_zero(seen_elems, 256);
 
 	for_each_element(elem, params->start, params->len) {
+		const struct ieee80211_elem_desc *desc =
+			&ieee80211_elem_descs[elem->id];
 		const struct element *subelem;
 		bool elem_parse_failed;
 		u8 id = elem->id;
@@ -1073,61 +1155,21 @@ _ieee802_11_parse_elems_full(struct ieee80211_elems_parse_params *params,
 						   check_inherit))
 			continue;
 
-		switch (id) {
-		case WLAN_EID_SSID:
-		case WLAN_EID_SUPP_RATES:
-		case WLAN_EID_FH_PARAMS:
-		case WLAN_EID_DS_PARAMS:
-		case WLAN_EID_CF_PARAMS:
-		case WLAN_EID_TIM:
-		case WLAN_EID_IBSS_PARAMS:
-		case WLAN_EID_CHALLENGE:
-		case WLAN_EID_RSN:
-		case WLAN_EID_ERP_INFO:
-		case WLAN_EID_EXT_SUPP_RATES:
-		case WLAN_EID_HT_CAPABILITY:
-		case WLAN_EID_HT_OPERATION:
-		case WLAN_EID_VHT_CAPABILITY:
-		case WLAN_EID_VHT_OPERATION:
-		case WLAN_EID_MESH_ID:
-		case WLAN_EID_MESH_CONFIG:
-		case WLAN_EID_PEER_MGMT:
-		case WLAN_EID_PREQ:
-		case WLAN_EID_PREP:
-		case WLAN_EID_PERR:
-		case WLAN_EID_RANN:
-		case WLAN_EID_CHANNEL_SWITCH:
-		case WLAN_EID_EXT_CHANSWITCH_ANN:
-		case WLAN_EID_COUNTRY:
-		case WLAN_EID_PWR_CONSTRAINT:
-		case WLAN_EID_TIMEOUT_INTERVAL:
-		case WLAN_EID_SECONDARY_CHANNEL_OFFSET:
-		case WLAN_EID_WIDE_BW_CHANNEL_SWITCH:
-		case WLAN_EID_CHAN_SWITCH_PARAM:
-		case WLAN_EID_EXT_CAPABILITY:
-		case WLAN_EID_CHAN_SWITCH_TIMING:
-		case WLAN_EID_LINK_ID:
-		case WLAN_EID_BSS_MAX_IDLE_PERIOD:
-		case WLAN_EID_RSNX:
-		case WLAN_EID_S1G_BCN_COMPAT:
-		case WLAN_EID_S1G_CAPABILITIES:
-		case WLAN_EID_S1G_OPERATION:
-		case WLAN_EID_AID_RESPONSE:
-		case WLAN_EID_S1G_SHORT_BCN_INTERVAL:
-		/*
-		 * not listing WLAN_EID_CHANNEL_SWITCH_WRAPPER -- it seems possible
-		 * that if the content gets bigger it might be needed more than once
-		 */
-			if (test_bit(id, seen_elems)) {
-				elems->parse_error = true;
-				continue;
-			}
-			break;
+		if (desc->flags & IEEE80211_ELEM_UNIQUE &&
+		    test_bit(id, seen_elems)) {
+			elems->parse_error = true;
+			continue;
 		}
 
 		if (calc_crc && id < 64 && (params->filter & (1ULL << id)))
 			crc = crc32_be(crc, pos - 2, elen + 2);
 
+		if (params->classes && !(desc->classes & params->classes) &&
+		    !(calc_crc && desc->flags & IEEE80211_ELEM_CRC)) {
+			__set_bit(id, seen_elems);
+			continue;
+		}
+
 		elem_parse_failed = false;
 
 		switch (id) {
@@ -1620,6 +1662,7 @@ static void ieee80211_mle_parse_link(struct ieee802_11_elems *elems,
 		.action = params->action,
 		.from_ap = params->from_ap,
 		.link_id = -1,
+		.classes = params->classes,
 	};
 	ssize_t ml_len = elems->ml_basic_len;
 	const struct element *non_inherit = NULL;
@@ -1709,6 +1752,7 @@ ieee802_11_parse_elems_full(struct ieee80211_elems_parse_params *params)
 			.len = nontransmitted_profile_len,
 			.action = params->action,
 			.link_id = params->link_id,
+			.classes = params->classes,
 		};
 
 		_ieee802_11_parse_elems_full(&sub, elems, NULL);